@@ -0,0 +1,57 @@
+#include "storage_bench.h"
+
+static const char* TAG = "bench_fanout";
+
+static const size_t DIRECTORY_SIZES[] = {64, 256, 1024};
+static const size_t LOOKUPS = 200;
+
+/**
+ * @brief exists() and read_file() latency against directory size, with and without fan-out
+ * 
+ * All keys live in one logical directory. The directory cache does not
+ * serve these calls and the metadata index is left to its build default, so
+ * with STORAGE_ENABLE_METADATA_INDEX off every lookup reaches the filesystem.
+ */
+void bench_fanout_lookup(const bench_target& target) {
+    storage_esp_config config;
+    config.versioning = false;
+    
+    for (size_t files : DIRECTORY_SIZES) {
+        for (bool fanout : {false, true}) {
+            config.key_fanout = fanout;
+            storage_esp storage(target.type, target.partition, target.mount_point, config);
+            if (!bench_prepare(storage)) {
+                return;
+            }
+            
+            uint8_t data[32] = {0};
+            bool filled = true;
+            for (size_t i = 0; i < files && filled; i++) {
+                filled = storage.write_file("flat/key" + std::to_string(i), data, sizeof(data));
+            }
+            if (!filled) {
+                ESP_LOGW(TAG, "%zu files do not fit, skipping", files);
+                storage.format();
+                return;
+            }
+            
+            // A fixed stride visits keys all over the directory
+            bench_samples exists, read;
+            for (size_t i = 0; i < LOOKUPS; i++) {
+                std::string key = "flat/key" + std::to_string((i * 7919) % files);
+                int64_t start_us = esp_timer_get_time();
+                storage.exists(key);
+                exists.add(esp_timer_get_time() - start_us);
+                
+                start_us = esp_timer_get_time();
+                storage.read_file(key, data, sizeof(data));
+                read.add(esp_timer_get_time() - start_us);
+            }
+            
+            ESP_LOGI(TAG, "%zu files, fan-out %s: exists mean %lld us p99 %lld us, read mean %lld us p99 %lld us",
+                     files, fanout ? "on" : "off", (long long)exists.mean(), (long long)exists.percentile(99),
+                     (long long)read.mean(), (long long)read.percentile(99));
+            storage.format();
+        }
+    }
+}
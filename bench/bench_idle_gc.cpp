@@ -0,0 +1,64 @@
+#include "storage_bench.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char* TAG = "bench_idle_gc";
+
+static const size_t FILE_SIZE = 4096;
+static const uint32_t FILL_PERCENT = 60;
+static const size_t BURSTS = 10;
+static const size_t BURST_WRITES = 20;
+
+/**
+ * @brief p99 write latency under churn, with the idle collector off and on
+ * 
+ * The partition is filled to FILL_PERCENT with FILE_SIZE files, then bursts
+ * of overwrites leave deleted pages behind, each followed by a quiet spell
+ * long enough for the idle task to collect. SPIFFS is where this shows:
+ * LittleFS has nothing to collect, so both rows should match there.
+ */
+void bench_idle_gc(const bench_target& target) {
+    storage_esp_config config;
+    config.versioning = false;
+    config.idle_gc_delay_ms = 200;
+    config.idle_gc_poll_ms = 50;
+    uint32_t quiet_ms = config.idle_gc_delay_ms + 4 * config.idle_gc_poll_ms;
+    
+    for (bool idle_gc : {false, true}) {
+        config.idle_gc = idle_gc;
+        storage_esp storage(target.type, target.partition, target.mount_point, config);
+        if (!bench_prepare(storage)) {
+            return;
+        }
+        
+        std::vector<uint8_t> data(FILE_SIZE, 0xA5);
+        size_t files = 0;
+        while (storage.used_size() + FILE_SIZE < storage.total_size() * FILL_PERCENT / 100 &&
+               storage.write_file("churn/f" + std::to_string(files), data.data(), data.size())) {
+            files++;
+        }
+        if (files == 0) {
+            ESP_LOGE(TAG, "Could not fill the partition");
+            storage.format();
+            return;
+        }
+        
+        bench_samples latency;
+        for (size_t burst = 0; burst < BURSTS; burst++) {
+            vTaskDelay(pdMS_TO_TICKS(quiet_ms));
+            for (size_t i = 0; i < BURST_WRITES; i++) {
+                // A fixed stride spreads the overwrites over every file
+                size_t index = ((burst * BURST_WRITES + i) * 7919) % files;
+                data[0] = (uint8_t)i;
+                int64_t start_us = esp_timer_get_time();
+                storage.write_file("churn/f" + std::to_string(index), data.data(), data.size());
+                latency.add(esp_timer_get_time() - start_us);
+            }
+        }
+        
+        ESP_LOGI(TAG, "idle GC %s, %zu files: write mean %lld us p99 %lld us max %lld us, %u collections",
+                 idle_gc ? "on" : "off", files, (long long)latency.mean(), (long long)latency.percentile(99),
+                 (long long)latency.percentile(100), (unsigned)storage.get_gc_runs());
+        storage.format();
+    }
+}
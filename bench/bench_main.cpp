@@ -0,0 +1,15 @@
+#include "storage_bench.h"
+
+/**
+ * @brief Runs every benchmark against the default partition, which it formats
+ */
+extern "C" void app_main(void) {
+    bench_target target;
+    
+    bench_parallel_walk(target);
+    bench_fanout_lookup(target);
+    bench_range_write(target);
+    bench_policy_overhead(target);
+    bench_idle_gc(target);
+    bench_power_loss(target);
+}
@@ -0,0 +1,80 @@
+#include "storage_bench.h"
+#include <atomic>
+#include <cstdio>
+
+static const char* TAG = "bench_walk";
+
+static const size_t DIRECTORIES = 16;
+static const size_t FILES_PER_DIRECTORY = 16;
+static const size_t MAX_WORKERS = 4;
+static const int RUNS = 5;
+
+/**
+ * @brief for_each_file_parallel() wall time against the number of workers
+ * 
+ * The visitor reads and checksums each file, the kind of bulk job the
+ * parallel walk is for. One worker is the calling task alone; the serial for_each_file() is
+ * the baseline.
+ */
+void bench_parallel_walk(const bench_target& target) {
+    storage_esp_config config;
+    config.versioning = false;
+    storage_esp storage(target.type, target.partition, target.mount_point, config);
+    if (!bench_prepare(storage)) {
+        return;
+    }
+    
+    std::vector<uint8_t> data(512, 0x5a);
+    for (size_t d = 0; d < DIRECTORIES; d++) {
+        for (size_t f = 0; f < FILES_PER_DIRECTORY; f++) {
+            std::string key = "walk/d" + std::to_string(d) + "/f" + std::to_string(f);
+            if (!storage.write_file(key, data.data(), data.size())) {
+                ESP_LOGE(TAG, "Failed to create %s", key.c_str());
+                return;
+            }
+        }
+    }
+    
+    std::atomic<size_t> visited(0);
+    // Reads through stdio: the storage API would serialize the workers on its lock
+    std::string base_path = storage.get_base_path();
+    auto visitor = [&base_path, &visited](const file_info_t& info) {
+        FILE* f = fopen((base_path + "/" + info.path).c_str(), "rb");
+        if (f) {
+            uint8_t buffer[128];
+            uint32_t sum = 0;
+            size_t length;
+            while ((length = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+                for (size_t i = 0; i < length; i++) {
+                    sum = sum * 31 + buffer[i];
+                }
+            }
+            fclose(f);
+        }
+        visited++;
+        return true;
+    };
+    
+    bench_samples serial;
+    for (int run = 0; run < RUNS; run++) {
+        visited = 0;
+        int64_t start_us = esp_timer_get_time();
+        storage.for_each_file(visitor, "walk");
+        serial.add(esp_timer_get_time() - start_us);
+    }
+    ESP_LOGI(TAG, "serial: %zu files, mean %lld us", visited.load(), (long long)serial.mean());
+    
+    for (size_t workers = 1; workers <= MAX_WORKERS; workers++) {
+        bench_samples parallel;
+        for (int run = 0; run < RUNS; run++) {
+            visited = 0;
+            int64_t start_us = esp_timer_get_time();
+            storage.for_each_file_parallel(visitor, "walk", workers);
+            parallel.add(esp_timer_get_time() - start_us);
+        }
+        ESP_LOGI(TAG, "%zu workers: %zu files, mean %lld us (%.2fx serial)", workers, visited.load(),
+                 (long long)parallel.mean(), (double)serial.mean() / std::max<int64_t>(parallel.mean(), 1));
+    }
+    
+    storage.format();
+}
@@ -0,0 +1,96 @@
+#include "storage_bench.h"
+#include <cstdio>
+
+static const char* TAG = "bench_policy";
+
+static const size_t FILE_SIZES[] = {32, 512, 4096};
+static const size_t FILES = 100;
+
+/**
+ * @brief Writes then reads FILES fresh keys of one size through a storage instance
+ */
+template <class Storage>
+static void measure_storage(Storage& storage, const char* name, size_t size) {
+    std::vector<uint8_t> data(size, 0x5A);
+    bench_samples write, read;
+    
+    for (size_t i = 0; i < FILES; i++) {
+        std::string key = "p" + std::to_string(size) + "_" + std::to_string(i);
+        int64_t start_us = esp_timer_get_time();
+        storage.write_file(key, data.data(), data.size());
+        write.add(esp_timer_get_time() - start_us);
+    }
+    for (size_t i = 0; i < FILES; i++) {
+        std::string key = "p" + std::to_string(size) + "_" + std::to_string(i);
+        int64_t start_us = esp_timer_get_time();
+        storage.read_file(key, data.data(), data.size());
+        read.add(esp_timer_get_time() - start_us);
+    }
+    
+    ESP_LOGI(TAG, "%s, %zu bytes: write mean %lld us p99 %lld us, read mean %lld us p99 %lld us",
+             name, size, (long long)write.mean(), (long long)write.percentile(99),
+             (long long)read.mean(), (long long)read.percentile(99));
+}
+
+/**
+ * @brief The same writes and reads with fopen()/fwrite()/fread() on the mount point
+ */
+static void measure_stdio(const std::string& mount_point, size_t size) {
+    std::vector<uint8_t> data(size, 0x5A);
+    bench_samples write, read;
+    
+    for (size_t i = 0; i < FILES; i++) {
+        std::string path = mount_point + "/s" + std::to_string(size) + "_" + std::to_string(i);
+        int64_t start_us = esp_timer_get_time();
+        FILE* f = fopen(path.c_str(), "wb");
+        if (f) {
+            fwrite(data.data(), 1, data.size(), f);
+            fclose(f);
+        }
+        write.add(esp_timer_get_time() - start_us);
+    }
+    for (size_t i = 0; i < FILES; i++) {
+        std::string path = mount_point + "/s" + std::to_string(size) + "_" + std::to_string(i);
+        int64_t start_us = esp_timer_get_time();
+        FILE* f = fopen(path.c_str(), "rb");
+        if (f) {
+            fread(data.data(), 1, data.size(), f);
+            fclose(f);
+        }
+        read.add(esp_timer_get_time() - start_us);
+    }
+    
+    ESP_LOGI(TAG, "stdio, %zu bytes: write mean %lld us p99 %lld us, read mean %lld us p99 %lld us",
+             size, (long long)write.mean(), (long long)write.percentile(99),
+             (long long)read.mean(), (long long)read.percentile(99));
+}
+
+/**
+ * @brief write_file()/read_file() cost of storage_esp_minimal and storage_esp against plain stdio
+ * 
+ * Every write creates a new file, so versioning in the default policy set
+ * writes metadata but never archives. stdio runs on the same mount while
+ * the minimal instance holds it.
+ */
+void bench_policy_overhead(const bench_target& target) {
+    for (size_t size : FILE_SIZES) {
+        {
+            storage_esp storage(target.type, target.partition, target.mount_point);
+            if (!bench_prepare(storage)) {
+                return;
+            }
+            measure_storage(storage, "storage_esp", size);
+            storage.format();
+        }
+        
+        storage_esp_minimal storage(target.type, target.partition, target.mount_point);
+        if (!bench_prepare(storage)) {
+            return;
+        }
+        measure_storage(storage, "storage_esp_minimal", size);
+        storage.format();
+        
+        measure_stdio(target.mount_point, size);
+        storage.format();
+    }
+}
@@ -0,0 +1,23 @@
+#include "storage_bench.h"
+#include "storage_fault_harness.h"
+#include <memory>
+
+static const char* TAG = "bench_power_loss";
+
+/**
+ * @brief Crash the built-in fault scenarios at every boundary and report recovery time
+ * 
+ * Needs STORAGE_ENABLE_FAULT_INJECTION, which is meant for the linux target;
+ * without it the harness logs that injection is off and nothing runs.
+ */
+void bench_power_loss(const bench_target& target) {
+    storage_fault_harness harness([&target] {
+        return std::unique_ptr<storage_esp>(new storage_esp(target.type, target.partition, target.mount_point));
+    });
+    
+    size_t failures = 0;
+    for (const auto& scenario : storage_fault_harness::builtin_scenarios()) {
+        failures += storage_fault_harness::report(scenario.name, harness.run(scenario));
+    }
+    ESP_LOGI(TAG, "%u inconsistent boundaries in total", (unsigned)failures);
+}
@@ -0,0 +1,63 @@
+#include "storage_bench.h"
+#include "storage_esp_impl.h"  // instantiates the policy set below
+
+static const char* TAG = "bench_range_write";
+
+static const size_t STATE_SIZE = 32 * 1024;
+static const size_t UPDATE_SIZE = 4;
+static const size_t UPDATES = 50;
+
+// Versioning is compiled in and stats are on, whatever the build defaults
+using bench_range_storage = basic_storage_esp<storage_default_lock, storage_versioning_on,
+                                              storage_io_stats, storage_default_log>;
+
+/**
+ * @brief Bytes programmed per small update: write_file() rewrite against write_file_range()
+ * 
+ * Each update changes UPDATE_SIZE bytes of a STATE_SIZE file. Bytes
+ * programmed are the driver's own write counters, so archives, patches and
+ * version metadata written by versioning are included.
+ */
+void bench_range_write(const bench_target& target) {
+    storage_esp_config config;
+    
+    for (bool versioning : {false, true}) {
+        for (bool range : {false, true}) {
+            config.versioning = versioning;
+            bench_range_storage storage(target.type, target.partition, target.mount_point, config);
+            if (!bench_prepare(storage)) {
+                return;
+            }
+            
+            std::vector<uint8_t> state(STATE_SIZE, 0);
+            if (!storage.write_file("state", state.data(), state.size())) {
+                ESP_LOGE(TAG, "Could not write the state file");
+                storage.format();
+                return;
+            }
+            
+            uint64_t written_before = storage.get_stats().get_bytes_written();
+            bench_samples latency;
+            for (uint32_t i = 0; i < UPDATES; i++) {
+                // Spread the counter across the file
+                size_t offset = (i * 7919 * UPDATE_SIZE) % (STATE_SIZE - UPDATE_SIZE);
+                memcpy(state.data() + offset, &i, UPDATE_SIZE);
+                
+                int64_t start_us = esp_timer_get_time();
+                bool ok = range ? storage.write_file_range("state", offset, state.data() + offset, UPDATE_SIZE)
+                                : storage.write_file("state", state.data(), state.size());
+                latency.add(esp_timer_get_time() - start_us);
+                if (!ok) {
+                    ESP_LOGE(TAG, "Update %u failed", (unsigned)i);
+                    break;
+                }
+            }
+            uint64_t programmed = storage.get_stats().get_bytes_written() - written_before;
+            
+            ESP_LOGI(TAG, "%s, versioning %s: %llu bytes programmed per %zu byte update, mean %lld us",
+                     range ? "write_file_range" : "write_file", versioning ? "on" : "off",
+                     (unsigned long long)(programmed / UPDATES), UPDATE_SIZE, (long long)latency.mean());
+            storage.format();
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "storage_esp.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Benchmarks for the storage driver
+ * 
+ * Not part of the storage component: build bench/ into an application (see
+ * the README). Every benchmark formats the partition it is given, mounts its
+ * own instances there one at a time and logs one line per measurement.
+ */
+
+/**
+ * @brief Partition a benchmark may format and use
+ */
+struct bench_target {
+    storage_type_t type = STORAGE_DEFAULT_TYPE;
+    std::string partition = STORAGE_DEFAULT_PARTITION_LABEL;
+    std::string mount_point = STORAGE_DEFAULT_BASE_PATH;
+};
+
+/**
+ * @brief Latency samples in microseconds
+ */
+class bench_samples {
+    public:
+        void add(int64_t us) { _samples.push_back(us); }
+        size_t count() const { return _samples.size(); }
+
+        int64_t mean() const {
+            int64_t total = 0;
+            for (int64_t us : _samples) {
+                total += us;
+            }
+            return _samples.empty() ? 0 : total / (int64_t)_samples.size();
+        }
+
+        int64_t percentile(uint32_t percentile) const {
+            if (_samples.empty()) {
+                return 0;
+            }
+            std::vector<int64_t> sorted(_samples);
+            std::sort(sorted.begin(), sorted.end());
+            size_t rank = (sorted.size() * percentile + 99) / 100;
+            return sorted[rank == 0 ? 0 : rank - 1];
+        }
+
+    private:
+        std::vector<int64_t> _samples;
+};
+
+/**
+ * @brief Mount storage on the target and start from an empty filesystem
+ */
+template <class Storage>
+bool bench_prepare(Storage& storage) {
+    if (!storage.begin() || !storage.format()) {
+        ESP_LOGE("storage_bench", "Could not mount and format the benchmark partition");
+        return false;
+    }
+    return true;
+}
+
+// ===== Benchmarks =====
+void bench_parallel_walk(const bench_target& target);
+void bench_fanout_lookup(const bench_target& target);
+void bench_range_write(const bench_target& target);
+void bench_policy_overhead(const bench_target& target);
+void bench_idle_gc(const bench_target& target);
+void bench_power_loss(const bench_target& target);
@@ -0,0 +1,123 @@
+#include "dir_cache.h"
+#include "dir_walker.h"
+
+dir_cache::dir_cache(size_t max_dirs)
+    : _max_dirs(max_dirs), _hits(0), _misses(0) {
+}
+
+bool dir_cache::lookup(const std::string& dir, uint32_t attributes, std::vector<file_info_t>& entries) {
+    if (!enabled()) {
+        return false;
+    }
+    
+    cached_dir* cached = _find(dir);
+    if (cached == nullptr || (cached->attributes & attributes) != attributes) {
+        _misses++;
+        return false;
+    }
+    
+    entries.insert(entries.end(), cached->entries.begin(), cached->entries.end());
+    _hits++;
+    return true;
+}
+
+void dir_cache::store(const std::string& dir, uint32_t attributes, const std::vector<file_info_t>& entries) {
+    if (!enabled()) {
+        return;
+    }
+    
+    cached_dir* cached = _find(dir);
+    if (cached != nullptr) {
+        cached->attributes = attributes;
+        cached->entries = entries;
+        return;
+    }
+    
+    if (_lru.size() >= _max_dirs) {
+        _lru.pop_back();
+    }
+    _lru.push_front({dir, attributes, entries});
+}
+
+// ========== Mutation Notifications ==========
+
+void dir_cache::note_file_written(const std::string& dir, const std::string& name, size_t size) {
+    _upsert(dir, name, size, false);
+}
+
+void dir_cache::note_directory_created(const std::string& dir, const std::string& name) {
+    _upsert(dir, name, 0, true);
+}
+
+void dir_cache::note_removed(const std::string& dir, const std::string& name) {
+    for (auto& cached : _lru) {
+        if (cached.dir != dir) {
+            continue;
+        }
+        for (auto it = cached.entries.begin(); it != cached.entries.end(); ++it) {
+            if (it->path == name) {
+                cached.entries.erase(it);
+                break;
+            }
+        }
+        return;
+    }
+}
+
+void dir_cache::invalidate(const std::string& dir) {
+    for (auto it = _lru.begin(); it != _lru.end(); ++it) {
+        if (it->dir == dir) {
+            _lru.erase(it);
+            return;
+        }
+    }
+}
+
+void dir_cache::invalidate_tree(const std::string& dir) {
+    for (auto it = _lru.begin(); it != _lru.end();) {
+        if (dir.empty() || it->dir == dir || dir_walker::matches_prefix(it->dir, dir + "/")) {
+            it = _lru.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void dir_cache::clear() {
+    _lru.clear();
+}
+
+// ========== Private Helper Methods ==========
+
+dir_cache::cached_dir* dir_cache::_find(const std::string& dir) {
+    for (auto it = _lru.begin(); it != _lru.end(); ++it) {
+        if (it->dir == dir) {
+            // Move to front to keep LRU order
+            _lru.splice(_lru.begin(), _lru, it);
+            return &_lru.front();
+        }
+    }
+    return nullptr;
+}
+
+void dir_cache::_upsert(const std::string& dir, const std::string& name, size_t size, bool is_directory) {
+    for (auto& cached : _lru) {
+        if (cached.dir != dir) {
+            continue;
+        }
+        
+        file_info_t info;
+        info.path = name;
+        info.size = (cached.attributes & STORAGE_ATTR_SIZE) ? size : 0;
+        info.is_directory = (cached.attributes & STORAGE_ATTR_TYPE) ? is_directory : false;
+        
+        for (auto& entry : cached.entries) {
+            if (entry.path == name) {
+                entry = info;
+                return;
+            }
+        }
+        cached.entries.push_back(info);
+        return;
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "interface/storage_interface.h"
+#include <string>
+#include <vector>
+#include <list>
+#include <cstdint>
+
+/**
+ * @brief Bounded LRU cache of directory listings
+ * 
+ * Keyed by directory path relative to the mount point, without leading or
+ * trailing slashes ("" is the root). Entries are stored by name only so a hit
+ * can be served for any spelling of the directory path. The owner reports
+ * every mutation so cached listings are patched in place instead of dropped.
+ * Not thread safe - the owner serializes access.
+ */
+class dir_cache {
+    public:
+        /**
+         * @param max_dirs Maximum number of directories kept; 0 disables caching
+         */
+        explicit dir_cache(size_t max_dirs);
+
+        bool enabled() const { return _max_dirs > 0; }
+
+        /**
+         * @brief Fetch a cached listing
+         * @param attributes storage_attr_t flags the caller needs
+         * @param entries Receives the entries (path holds the entry name only)
+         * @return true on a hit that covers the requested attributes
+         */
+        bool lookup(const std::string& dir, uint32_t attributes, std::vector<file_info_t>& entries);
+
+        /**
+         * @brief Store a complete listing of dir (entry paths hold names only)
+         */
+        void store(const std::string& dir, uint32_t attributes, const std::vector<file_info_t>& entries);
+
+        // ===== Mutation notifications =====
+        void note_file_written(const std::string& dir, const std::string& name, size_t size);
+        void note_directory_created(const std::string& dir, const std::string& name);
+        void note_removed(const std::string& dir, const std::string& name);
+        void invalidate(const std::string& dir);
+        void invalidate_tree(const std::string& dir);
+        void clear();
+
+        // ===== Statistics =====
+        uint32_t get_hits() const { return _hits; }
+        uint32_t get_misses() const { return _misses; }
+
+    private:
+        struct cached_dir {
+            std::string dir;
+            uint32_t attributes;
+            std::vector<file_info_t> entries;
+        };
+
+        size_t _max_dirs;
+        std::list<cached_dir> _lru;  // Most recently used first
+        uint32_t _hits;
+        uint32_t _misses;
+
+        cached_dir* _find(const std::string& dir);
+        void _upsert(const std::string& dir, const std::string& name, size_t size, bool is_directory);
+};
@@ -0,0 +1,238 @@
+#include "dir_walker.h"
+#include "key_fanout.h"
+#include "storage_glob.h"
+#include "storage_config.h"
+#include "esp_log.h"
+#include <sys/stat.h>
+#include <cstring>
+
+static const char* TAG = "dir_walker";
+
+static walk_options_t prefix_options(const std::string& prefix) {
+    walk_options_t options;
+    options.prefix = prefix;
+    return options;
+}
+
+dir_walker::dir_walker(const std::string& base_path, const std::string& prefix)
+    : dir_walker(base_path, prefix_options(prefix)) {
+}
+
+dir_walker::dir_walker(const std::string& base_path, const walk_options_t& options)
+    : _base_path(base_path), _options(options) {
+    
+    _options.prefix = normalize_prefix(_options.prefix);
+    if (_options.prefix.empty() && !_options.pattern.empty()) {
+        _options.pattern = normalize_prefix(_options.pattern);
+        _options.prefix = storage_glob::literal_prefix(_options.pattern);
+    }
+    std::string start_dir = start_directory(_options.prefix);
+    
+    _open_dir(start_dir, start_dir);
+}
+
+dir_walker::~dir_walker() {
+    close();
+}
+
+dir_walker::dir_walker(dir_walker&& other) noexcept
+    : _base_path(std::move(other._base_path)),
+      _options(std::move(other._options)),
+      _stack(std::move(other._stack)) {
+    other._stack.clear();
+}
+
+dir_walker& dir_walker::operator=(dir_walker&& other) noexcept {
+    if (this != &other) {
+        close();
+        _base_path = std::move(other._base_path);
+        _options = std::move(other._options);
+        _stack = std::move(other._stack);
+        other._stack.clear();
+    }
+    return *this;
+}
+
+bool dir_walker::next(file_info_t& info) {
+    while (!_stack.empty()) {
+        struct dirent* entry = readdir(_stack.back().dir);
+        if (entry == NULL) {
+            closedir(_stack.back().dir);
+            _stack.pop_back();
+            continue;
+        }
+        
+        // Skip . and ..
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+        
+        const frame& parent = _stack.back();
+        if (is_reserved(parent.path, entry->d_name)) {
+            continue;
+        }
+        std::string physical = join(parent.path, entry->d_name);
+        
+        // Buckets are invisible: their contents belong to the parent directory
+        if (_options.fanout && key_fanout::is_bucket(entry->d_name)) {
+            std::string logical = parent.logical;
+            _open_dir(physical, logical);
+            continue;
+        }
+        
+        std::string path = join(parent.logical, entry->d_name);
+        
+        // Entries that neither match nor lead to a match need no attributes
+        if (!matches_prefix(path, _options.prefix) && !may_contain_prefix(path, _options.prefix)) {
+            continue;
+        }
+        if (!_options.pattern.empty() &&
+            !storage_glob::match(_options.pattern, path) &&
+            !storage_glob::may_match_below(_options.pattern, path)) {
+            continue;
+        }
+        
+        // Recursion and file-only filtering both depend on the entry type
+        uint32_t attributes = _options.attributes;
+        if (_options.recursive || !_options.include_directories) {
+            attributes |= STORAGE_ATTR_TYPE;
+        }
+        
+        if (!read_attributes(_get_full_path(physical), entry, attributes, info)) {
+            continue;
+        }
+        
+        if (info.is_directory) {
+            if (_options.recursive && may_contain_prefix(path, _options.prefix) &&
+                (_options.pattern.empty() || storage_glob::may_match_below(_options.pattern, path))) {
+                _open_dir(physical, path);
+            }
+            if (!_options.include_directories) {
+                continue;
+            }
+        }
+        
+        if (!matches_prefix(path, _options.prefix)) {
+            continue;
+        }
+        if (!_options.pattern.empty() && !storage_glob::match(_options.pattern, path)) {
+            continue;
+        }
+        
+        info.path = path;
+        if (_options.filter && !_options.filter(info)) {
+            continue;
+        }
+        return true;
+    }
+    
+    return false;
+}
+
+void dir_walker::close() {
+    for (auto& f : _stack) {
+        closedir(f.dir);
+    }
+    _stack.clear();
+}
+
+// ========== Private Helper Methods ==========
+
+bool dir_walker::_open_dir(const std::string& path, const std::string& logical) {
+    DIR* dir = opendir(_get_full_path(path).c_str());
+    if (!dir) {
+        ESP_LOGD(TAG, "Failed to open directory: %s", path.c_str());
+        return false;
+    }
+    
+    _stack.push_back({dir, path, logical});
+    return true;
+}
+
+std::string dir_walker::_get_full_path(const std::string& path) const {
+    if (path.empty()) {
+        return _base_path;
+    }
+    return _base_path + "/" + path;
+}
+
+// ========== Attribute Helpers ==========
+
+bool dir_walker::read_attributes(const std::string& full_path, const struct dirent* entry,
+                                 uint32_t attributes, file_info_t& info) {
+    info.size = 0;
+    info.is_directory = false;
+    
+    bool need_type = (attributes & STORAGE_ATTR_TYPE) != 0;
+    bool need_size = (attributes & STORAGE_ATTR_SIZE) != 0;
+    
+#ifdef DT_DIR
+    // d_type answers the type question without touching the filesystem
+    if (need_type && entry != NULL && entry->d_type != DT_UNKNOWN) {
+        info.is_directory = (entry->d_type == DT_DIR);
+        need_type = false;
+        if (info.is_directory) {
+            need_size = false;
+        }
+    }
+#endif
+    
+    if (!need_type && !need_size) {
+        return true;
+    }
+    
+    struct stat st;
+    if (stat(full_path.c_str(), &st) != 0) {
+        return false;
+    }
+    
+    info.is_directory = S_ISDIR(st.st_mode);
+    if (need_size && !info.is_directory) {
+        info.size = st.st_size;
+    }
+    return true;
+}
+
+// ========== Path Helpers ==========
+
+std::string dir_walker::join(const std::string& dir, const char* name) {
+    if (dir.empty()) {
+        return name;
+    }
+    return dir + "/" + name;
+}
+
+bool dir_walker::is_reserved(const std::string& dir, const char* name) {
+    // Only the root holds driver files; a bucket at the root is not the root
+    return dir.empty() && strncmp(name, STORAGE_RESERVED_PREFIX, strlen(STORAGE_RESERVED_PREFIX)) == 0;
+}
+
+std::string dir_walker::normalize_prefix(const std::string& prefix) {
+    // Keys never carry a leading slash
+    size_t start = prefix.find_first_not_of('/');
+    return (start == std::string::npos) ? "" : prefix.substr(start);
+}
+
+std::string dir_walker::start_directory(const std::string& prefix) {
+    // The deepest directory fully named by the prefix
+    size_t last_slash = prefix.rfind('/');
+    if (last_slash == std::string::npos) {
+        return "";
+    }
+    return prefix.substr(0, last_slash);
+}
+
+bool dir_walker::matches_prefix(const std::string& path, const std::string& prefix) {
+    return path.compare(0, prefix.length(), prefix) == 0;
+}
+
+bool dir_walker::may_contain_prefix(const std::string& dir_path, const std::string& prefix) {
+    // Either the directory already lies inside the prefix, or the prefix
+    // continues below this directory
+    if (matches_prefix(dir_path, prefix)) {
+        return true;
+    }
+    return prefix.length() > dir_path.length() &&
+           prefix.compare(0, dir_path.length(), dir_path) == 0 &&
+           prefix[dir_path.length()] == '/';
+}
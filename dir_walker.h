@@ -0,0 +1,133 @@
+#pragma once
+
+#include "interface/storage_interface.h"
+#include <string>
+#include <vector>
+#include <functional>
+#include <dirent.h>
+
+/**
+ * @brief Visitor invoked for every file produced by a walk
+ * @return false to stop the walk early
+ */
+using file_visitor_t = std::function<bool(const file_info_t&)>;
+
+/**
+ * @brief Entry attributes a listing caller needs filled in
+ * 
+ * Names are always reported. The type comes from dirent d_type when the VFS
+ * provides it; size always costs a stat(), so callers that only need it for
+ * a few entries should list without it and call file_size() afterwards.
+ */
+typedef enum {
+    STORAGE_ATTR_NAME = 0,
+    STORAGE_ATTR_TYPE = 1 << 0,
+    STORAGE_ATTR_SIZE = 1 << 1,
+    STORAGE_ATTR_ALL  = STORAGE_ATTR_TYPE | STORAGE_ATTR_SIZE
+} storage_attr_t;
+
+/**
+ * @brief Options controlling what a dir_walker reports
+ */
+struct walk_options_t {
+    std::string prefix;                      // Only report keys starting with this prefix
+    bool recursive = true;                   // Descend into subdirectories
+    bool include_directories = false;        // Report directory entries as well as files
+    uint32_t attributes = STORAGE_ATTR_ALL;  // storage_attr_t flags to fill in
+    bool fanout = false;                     // See through key_fanout buckets, report logical keys
+    std::string pattern;                     // storage_glob pattern keys must match (empty = all)
+    file_visitor_t filter;                   // Predicate reported entries must pass (empty = all)
+};
+
+/**
+ * @brief Lazy, resumable depth-first directory walker
+ * 
+ * Yields files one at a time straight from readdir() instead of building a
+ * list of the whole tree. Only the stack of currently open directories is
+ * kept in memory, so memory use depends on tree depth, not file count.
+ * Paths are reported relative to the base path, in the same form used as
+ * storage keys (e.g. "logs/2024/boot.txt").
+ */
+class dir_walker {
+    public:
+        /**
+         * @brief Start a walk below base_path
+         * @param base_path Filesystem mount point
+         * @param prefix Only report keys starting with this prefix; directories
+         *               that cannot contain matching keys are never opened
+         */
+        dir_walker(const std::string& base_path, const std::string& prefix = "");
+
+        /**
+         * @brief Start a walk below base_path with explicit options
+         * 
+         * A non-recursive walk with prefix "dir/" lists the entries of "dir".
+         * A glob pattern is matched during the walk and directories it cannot
+         * match below are never opened; without a prefix, the walk starts at
+         * the pattern's leading literal directories.
+         * Attributes not requested are reported as 0/false. Recursive walks and
+         * walks that exclude directories always resolve the entry type.
+         */
+        dir_walker(const std::string& base_path, const walk_options_t& options);
+        ~dir_walker();
+
+        dir_walker(dir_walker&& other) noexcept;
+        dir_walker& operator=(dir_walker&& other) noexcept;
+        dir_walker(const dir_walker&) = delete;
+        dir_walker& operator=(const dir_walker&) = delete;
+
+        /**
+         * @brief Advance to the next matching file
+         * @param info Filled with the file's key, size and type
+         * @return false once the walk is exhausted
+         */
+        bool next(file_info_t& info);
+
+        /**
+         * @brief Release all open directory handles and end the walk
+         */
+        void close();
+
+        bool done() const { return _stack.empty(); }
+
+        /**
+         * @brief Fill is_directory and size for one entry, as requested
+         * @param full_path Absolute path of the entry
+         * @param entry dirent the entry came from, or NULL to rely on stat()
+         * @param attributes storage_attr_t flags to fill in
+         * @return false if a required stat() failed
+         */
+        static bool read_attributes(const std::string& full_path, const struct dirent* entry,
+                                    uint32_t attributes, file_info_t& info);
+
+        /**
+         * @brief Join a directory path and an entry name
+         */
+        static std::string join(const std::string& dir, const char* name);
+
+        /**
+         * @brief Whether an entry is one of the driver's own files, not a key
+         * @param dir Physical directory relative to the base path ("" is the root)
+         */
+        static bool is_reserved(const std::string& dir, const char* name);
+
+        // Prefix helpers shared with other walkers
+        static std::string normalize_prefix(const std::string& prefix);
+        static std::string start_directory(const std::string& prefix);
+        static bool matches_prefix(const std::string& path, const std::string& prefix);
+        static bool may_contain_prefix(const std::string& dir_path, const std::string& prefix);
+
+    private:
+        struct frame {
+            DIR* dir;
+            std::string path;     // Physical path relative to the base path
+            std::string logical;  // Same path with fan-out buckets removed
+        };
+
+        std::string _base_path;
+        walk_options_t _options;
+        std::vector<frame> _stack;
+
+        bool _open_dir(const std::string& path, const std::string& logical);
+        std::string _get_full_path(const std::string& path) const;
+};
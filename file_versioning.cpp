@@ -2,11 +2,13 @@
 #include "esp_log.h"
 #include <algorithm>
 #include <sys/stat.h>
+#include <cstring>
+#include <cstdlib>
 
 static const char* TAG = "file_versioning";
 
 file_versioning::file_versioning(const storage_callbacks& callbacks)
-    : storage_ops(callbacks)
+    : storage_ops(callbacks), max_history(STORAGE_MAX_VERSION_HISTORY)
 #if STORAGE_ENABLE_MUTEX_PROTECTION
     , versioning_mutex(nullptr)
 #endif
@@ -31,6 +33,11 @@ file_versioning::~file_versioning() {
 #endif
 }
 
+void file_versioning::set_max_history(uint32_t versions) {
+    // The metadata layout reserves STORAGE_MAX_VERSION_HISTORY slots
+    max_history = std::max<uint32_t>(1, std::min<uint32_t>(versions, STORAGE_MAX_VERSION_HISTORY));
+}
+
 // ========== Public Version Query Methods ==========
 
 uint32_t file_versioning::get_file_version(const std::string& key) {
@@ -96,8 +103,7 @@ std::vector<file_version_info> file_versioning::list_file_versions(const std::st
         uint32_t version_num = metadata.versions[i];
         if (version_num == 0) continue;
         
-        std::string version_path = get_version_path(key, version_num);
-        size_t version_size = storage_ops.get_file_size(version_path);
+        size_t version_size = get_version_size(key, version_num);
         
         if (version_size > 0) {
             file_version_info historical;
@@ -133,9 +139,20 @@ bool file_versioning::read_file_version(const std::string& key, uint32_t version
     if (version == 0) {
         // Read current version
         file_path = key;
-    } else {
+    } else if (storage_ops.get_file_size(get_version_path(key, version)) > 0) {
         // Read specific version
         file_path = get_version_path(key, version);
+    } else {
+        // Version stored as a patch - rebuild it from newer versions
+        file_version_metadata metadata;
+        std::vector<uint8_t> version_data;
+        if (!load_metadata(key, metadata) ||
+            !reconstruct_version(key, metadata, version, version_data) || version_data.empty()) {
+            ESP_LOGW(TAG, "Failed to read file version %d: %s", version, key.c_str());
+            return false;
+        }
+        memcpy(data, version_data.data(), std::min(data_size, version_data.size()));
+        return true;
     }
     
     if (!storage_ops.read_file(file_path, data, data_size)) {
@@ -159,30 +176,39 @@ bool file_versioning::restore_file_version(const std::string& key, uint32_t vers
         return false;
     }
     
-    std::string version_path = get_version_path(key, version);
-    
     // Check if version exists
-    size_t version_size = storage_ops.get_file_size(version_path);
-    if (version_size == 0) {
+    if (get_version_size(key, version) == 0) {
         ESP_LOGE(TAG, "Version %d of %s does not exist", version, key.c_str());
         return false;
     }
     
-    // Read the version data
-    std::vector<uint8_t> version_data(version_size);
-    if (!storage_ops.read_file(version_path, version_data.data(), version_size)) {
-        ESP_LOGE(TAG, "Failed to read version file: %s", version_path.c_str());
+    // Read the version data (full archive, or rebuilt from patches)
+    file_version_metadata metadata;
+    load_metadata(key, metadata);
+    
+    std::vector<uint8_t> version_data;
+    if (!reconstruct_version(key, metadata, version, version_data)) {
+        ESP_LOGE(TAG, "Failed to read version %d of %s", version, key.c_str());
         return false;
     }
     
-    // Write as current version (this will create a new version automatically via on_before_write)
-    bool result = storage_ops.write_file(key, version_data.data(), version_data.size());
+    // Write as a new current version, archiving the one it replaces; the raw
+    // write callback bypasses the hooks, so do their work here in the same order
+    archive_current_version(key);
+    if (!storage_ops.write_file(key, version_data.data(), version_data.size())) {
+        return false;
+    }
     
-    if (result) {
-        ESP_LOGI(TAG, "Successfully restored %s to version %d", key.c_str(), version);
+    load_metadata(key, metadata);
+    metadata.current_version++;
+    metadata.file_size = version_data.size();
+    metadata.checksum = calculate_crc32(version_data.data(), version_data.size());
+    if (!save_metadata(key, metadata)) {
+        return false;
     }
     
-    return result;
+    ESP_LOGI(TAG, "Successfully restored %s to version %d", key.c_str(), version);
+    return true;
 }
 
 // ========== Public Version Management Methods ==========
@@ -218,26 +244,7 @@ bool file_versioning::archive_current_version(const std::string& key) {
         return false;
     }
     
-    // Update version list
-    bool version_exists = false;
-    for (uint32_t i = 0; i < metadata.version_count; i++) {
-        if (metadata.versions[i] == metadata.current_version) {
-            version_exists = true;
-            break;
-        }
-    }
-    
-    if (!version_exists) {
-        if (metadata.version_count < STORAGE_MAX_VERSION_HISTORY) {
-            metadata.versions[metadata.version_count] = metadata.current_version;
-            metadata.version_count++;
-        } else {
-            // Need to make room - remove oldest version
-            cleanup_oldest_version(key, metadata);
-            metadata.versions[metadata.version_count - 1] = metadata.current_version;
-        }
-        save_metadata(key, metadata);
-    }
+    record_archived_version(key, metadata);
     
 #if STORAGE_ENABLE_DEBUG_LOGGING
     ESP_LOGD(TAG, "Archived version %d of %s", metadata.current_version, key.c_str());
@@ -277,7 +284,7 @@ uint32_t file_versioning::cleanup_old_versions(const std::string& key) {
     }
     
     // Remove versions beyond the limit
-    while (metadata.version_count > STORAGE_MAX_VERSION_HISTORY) {
+    while (metadata.version_count > max_history) {
         if (cleanup_oldest_version(key, metadata)) {
             cleaned_count++;
         } else {
@@ -295,7 +302,45 @@ uint32_t file_versioning::cleanup_old_versions(const std::string& key) {
     return cleaned_count;
 }
 
-bool file_versioning::on_before_write(const std::string& key, const void* data, size_t size) {
+uint32_t file_versioning::remove_all_versions(const std::string& key) {
+    // Note: This method should only be called from within a mutex-protected context
+    // (e.g., from erase_file), so no additional mutex guard is needed here
+    
+    uint32_t removed_count = 0;
+    
+    if (!storage_ops.is_mounted() || key.empty()) {
+        return 0;
+    }
+    
+    file_version_metadata metadata;
+    if (!load_metadata(key, metadata)) {
+        return 0;
+    }
+    
+    // Delete every archived version, then the metadata that lists them
+    for (uint32_t i = 0; i < metadata.version_count; i++) {
+        if (metadata.versions[i] == 0) continue;
+        
+        if (delete_version_files(key, metadata.versions[i])) {
+            removed_count++;
+        }
+    }
+    
+    std::string meta_path = get_metadata_path(key);
+    if (storage_ops.file_exists(meta_path) && storage_ops.delete_file(meta_path)) {
+        removed_count++;
+    }
+    
+#if STORAGE_ENABLE_DEBUG_LOGGING
+    if (removed_count > 0) {
+        ESP_LOGD(TAG, "Removed %d versioning files of %s", removed_count, key.c_str());
+    }
+#endif
+    
+    return removed_count;
+}
+
+bool file_versioning::on_before_write(const std::string& key) {
 #if STORAGE_ENABLE_MUTEX_PROTECTION
     mutex_guard guard(versioning_mutex);
 #endif
@@ -304,34 +349,383 @@ bool file_versioning::on_before_write(const std::string& key, const void* data,
         return true; // Allow write to proceed
     }
     
-    file_version_metadata metadata;
-    load_metadata(key, metadata);
-    
-    // Archive current version if file exists
+    // Archive current version if file exists. Only the version list changes
+    // here; the live file is still the version the metadata describes.
     if (storage_ops.file_exists(key)) {
         archive_current_version(key);
     }
     
-    // Update metadata for new version
+    return true;
+}
+
+bool file_versioning::on_after_write(const std::string& key, const void* data, size_t size) {
+#if STORAGE_ENABLE_MUTEX_PROTECTION
+    mutex_guard guard(versioning_mutex);
+#endif
+    
+    if (!storage_ops.is_mounted()) {
+        return false;
+    }
+    
+    // Loaded after the archive step so its version list is kept
+    file_version_metadata metadata;
+    load_metadata(key, metadata);
+    
     metadata.current_version++;
     metadata.file_size = size;
     metadata.checksum = calculate_crc32(data, size);
     
-    save_metadata(key, metadata);
+    return save_metadata(key, metadata);
+}
+
+bool file_versioning::check_metadata(const std::string& key, std::string* problem) {
+    std::string meta_path = get_metadata_path(key);
+    size_t meta_size = storage_ops.get_file_size(meta_path);
+    if (meta_size == 0 && !storage_ops.file_exists(meta_path)) {
+        return true;
+    }
+    
+    std::string reason;
+    file_version_metadata metadata;
+    if (meta_size != sizeof(file_version_metadata) ||
+        !storage_ops.read_file(meta_path, &metadata, sizeof(metadata))) {
+        reason = "unreadable metadata";
+    } else if (!storage_ops.file_exists(key)) {
+        reason = "metadata without a live file";
+    } else if (metadata.version_count > STORAGE_MAX_VERSION_HISTORY) {
+        reason = "corrupt version list";
+    } else {
+        size_t size = storage_ops.get_file_size(key);
+        uint32_t crc = 0;
+        if (size != metadata.file_size || !calculate_file_crc32(key, size, crc) || crc != metadata.checksum) {
+            reason = "checksum does not match the live file";
+        }
+        for (uint32_t i = 0; i < metadata.version_count && reason.empty(); i++) {
+            if (get_version_size(key, metadata.versions[i]) == 0) {
+                reason = "version " + std::to_string(metadata.versions[i]) + " is listed but missing";
+            }
+        }
+    }
+    
+    if (problem) {
+        *problem = reason;
+    }
+    return reason.empty();
+}
+
+uint32_t file_versioning::repair_artifact(const std::string& path) {
+#if STORAGE_ENABLE_MUTEX_PROTECTION
+    mutex_guard guard(versioning_mutex);
+#endif
+    
+    std::string key;
+    uint32_t version = 0;
+    if (!storage_ops.is_mounted() || !parse_artifact_path(path, key, version)) {
+        return 0;
+    }
+    
+    std::string meta_path = get_metadata_path(key);
+    file_version_metadata metadata;
+    bool intact = storage_ops.get_file_size(meta_path) == sizeof(file_version_metadata) &&
+                  storage_ops.read_file(meta_path, &metadata, sizeof(metadata)) &&
+                  metadata.version_count <= STORAGE_MAX_VERSION_HISTORY;
+    
+    if (version != 0) {
+        // Power lost between writing an archive and recording it
+        if (!intact) {
+            return 0;
+        }
+        uint32_t oldest_listed = metadata.current_version;
+        for (uint32_t i = 0; i < metadata.version_count; i++) {
+            if (metadata.versions[i] == version) {
+                return 0;
+            }
+            oldest_listed = std::min(oldest_listed, metadata.versions[i]);
+        }
+        
+        // Only remove what the history could have left: the version being
+        // archived when power was lost, or an old one whose deletion failed.
+        // Anything else named like an archive may be a key of its own (fw.v9
+        // next to fw), as may a .pN file without a patch header.
+        if (version != metadata.current_version && version >= oldest_listed) {
+            return 0;
+        }
+        if (path[key.length() + 1] == 'p') {
+            version_patch_header header;
+            if (storage_ops.get_file_size(path) < sizeof(header) ||
+                !storage_ops.read_file(path, &header, sizeof(header)) ||
+                header.magic != PATCH_MAGIC) {
+                return 0;
+            }
+        }
+        ESP_LOGW(TAG, "Removing unlisted archive %s", path.c_str());
+        return storage_ops.delete_file(path) ? 1 : 0;
+    }
+    
+    // Power lost between deleting a file and its versioning files
+    if (!storage_ops.file_exists(key)) {
+        ESP_LOGW(TAG, "Removing metadata of missing file %s", key.c_str());
+        return remove_all_versions(key);
+    }
+    
+    size_t size = storage_ops.get_file_size(key);
+    uint32_t crc = 0;
+    if (!calculate_file_crc32(key, size, crc)) {
+        return 0;
+    }
+    
+    bool changed = false;
+    if (!intact) {
+        // Torn metadata: restart the history at the live file. The archives it
+        // listed are now unlisted; the checker's next pass removes those
+        // numbered below the new current version, and later archive writes
+        // replace the rest.
+        ESP_LOGW(TAG, "Resetting unreadable metadata of %s", key.c_str());
+        metadata = file_version_metadata();
+        changed = true;
+    }
+    
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < metadata.version_count; i++) {
+        if (get_version_size(key, metadata.versions[i]) > 0) {
+            metadata.versions[kept++] = metadata.versions[i];
+        }
+    }
+    if (kept != metadata.version_count) {
+        ESP_LOGW(TAG, "Dropping %u missing versions of %s", (unsigned)(metadata.version_count - kept), key.c_str());
+        for (uint32_t i = kept; i < metadata.version_count; i++) {
+            metadata.versions[i] = 0;
+        }
+        metadata.version_count = kept;
+        changed = true;
+    }
+    
+    // Power lost after the data write but before its metadata: the live file
+    // is a version the history never recorded
+    if (size != metadata.file_size || crc != metadata.checksum) {
+        ESP_LOGW(TAG, "Metadata of %s lags the live file, recording it as a new version", key.c_str());
+        metadata.current_version++;
+        metadata.file_size = size;
+        metadata.checksum = crc;
+        changed = true;
+    }
+    
+    if (!changed) {
+        return 0;
+    }
+    return save_metadata(key, metadata) ? 1 : 0;
+}
+
+bool file_versioning::on_before_write_range(const std::string& key, size_t offset, size_t size) {
+#if STORAGE_ENABLE_MUTEX_PROTECTION
+    mutex_guard guard(versioning_mutex);
+#endif
+    
+    if (!storage_ops.is_mounted() || !storage_ops.file_exists(key)) {
+        return true; // Nothing to archive - allow write to proceed
+    }
+    
+    file_version_metadata metadata;
+    load_metadata(key, metadata);
+    
+    // Save only the bytes of the current version that the write will replace
+    size_t base_size = storage_ops.get_file_size(key);
+    size_t saved_length = 0;
+    if (offset < base_size) {
+        saved_length = std::min(size, base_size - offset);
+    }
+    
+    std::vector<uint8_t> patch(sizeof(version_patch_header) + saved_length);
+    version_patch_header header;
+    header.magic = PATCH_MAGIC;
+    header.base_size = base_size;
+    header.offset = offset;
+    header.length = saved_length;
+    memcpy(patch.data(), &header, sizeof(header));
     
+    if (saved_length > 0 &&
+        !storage_ops.read_file_range(key, offset, patch.data() + sizeof(header), saved_length)) {
+        ESP_LOGE(TAG, "Failed to read span of %s for patch archive", key.c_str());
+        return false;
+    }
+    
+    std::string patch_path = get_patch_path(key, metadata.current_version);
+    if (!storage_ops.write_file(patch_path, patch.data(), patch.size())) {
+        ESP_LOGE(TAG, "Failed to write patch archive: %s", patch_path.c_str());
+        return false;
+    }
+    
+    // Without the metadata entry the patch could never be applied, and the
+    // in-place write would lose the bytes it replaces
+    if (!record_archived_version(key, metadata)) {
+        ESP_LOGE(TAG, "Failed to record patch archive: %s", patch_path.c_str());
+        storage_ops.delete_file(patch_path);
+        return false;
+    }
+    
+#if STORAGE_ENABLE_DEBUG_LOGGING
+    ESP_LOGD(TAG, "Archived version %d of %s as %zu byte patch",
+             metadata.current_version, key.c_str(), saved_length);
+#endif
     return true;
 }
 
+bool file_versioning::on_after_write_range(const std::string& key) {
+#if STORAGE_ENABLE_MUTEX_PROTECTION
+    mutex_guard guard(versioning_mutex);
+#endif
+    
+    if (!storage_ops.is_mounted()) {
+        return false;
+    }
+    
+    file_version_metadata metadata;
+    load_metadata(key, metadata);
+    
+    size_t new_size = storage_ops.get_file_size(key);
+    uint32_t crc = 0;
+    if (!calculate_file_crc32(key, new_size, crc)) {
+        return false;
+    }
+    
+    metadata.current_version++;
+    metadata.file_size = new_size;
+    metadata.checksum = crc;
+    
+    return save_metadata(key, metadata);
+}
+
 // ========== Private Helper Methods ==========
 
+// Artifact paths are storage keys, like every other argument to storage_ops
+
 std::string file_versioning::get_metadata_path(const std::string& key) const {
-    return storage_ops.get_full_path(key) + STORAGE_VERSION_METADATA_EXT;
+    return key + STORAGE_VERSION_METADATA_EXT;
 }
 
 std::string file_versioning::get_version_path(const std::string& key, uint32_t version) const {
     char version_suffix[32];
     snprintf(version_suffix, sizeof(version_suffix), ".v%d", version);
-    return storage_ops.get_full_path(key) + version_suffix;
+    return key + version_suffix;
+}
+
+std::string file_versioning::get_patch_path(const std::string& key, uint32_t version) const {
+    char patch_suffix[32];
+    snprintf(patch_suffix, sizeof(patch_suffix), ".p%d", version);
+    return key + patch_suffix;
+}
+
+bool file_versioning::parse_artifact_path(const std::string& path, std::string& key, uint32_t& version) const {
+    static const std::string meta_ext = STORAGE_VERSION_METADATA_EXT;
+    if (path.length() > meta_ext.length() &&
+        path.compare(path.length() - meta_ext.length(), meta_ext.length(), meta_ext) == 0) {
+        key = path.substr(0, path.length() - meta_ext.length());
+        version = 0;
+        return true;
+    }
+    
+    // <key>.v<digits> or <key>.p<digits>
+    size_t dot = path.rfind('.');
+    if (dot == std::string::npos || dot == 0 || dot + 2 >= path.length() ||
+        (path[dot + 1] != 'v' && path[dot + 1] != 'p') ||
+        path.find_first_not_of("0123456789", dot + 2) != std::string::npos) {
+        return false;
+    }
+    key = path.substr(0, dot);
+    version = strtoul(path.c_str() + dot + 2, NULL, 10);
+    return version != 0;
+}
+
+bool file_versioning::record_archived_version(const std::string& key, file_version_metadata& metadata) {
+    // Update version list
+    for (uint32_t i = 0; i < metadata.version_count; i++) {
+        if (metadata.versions[i] == metadata.current_version) {
+            return true;
+        }
+    }
+    
+    // Make room - remove oldest versions (more than one if the limit was lowered)
+    while (metadata.version_count >= max_history) {
+        if (!cleanup_oldest_version(key, metadata)) {
+            return false;
+        }
+    }
+    
+    metadata.versions[metadata.version_count] = metadata.current_version;
+    metadata.version_count++;
+    return save_metadata(key, metadata);
+}
+
+bool file_versioning::delete_version_files(const std::string& key, uint32_t version) {
+    // A version is archived either in full or as a patch
+    bool deleted = storage_ops.delete_file(get_version_path(key, version));
+    if (storage_ops.delete_file(get_patch_path(key, version))) {
+        deleted = true;
+    }
+    return deleted;
+}
+
+size_t file_versioning::get_version_size(const std::string& key, uint32_t version) {
+    size_t full_size = storage_ops.get_file_size(get_version_path(key, version));
+    if (full_size > 0) {
+        return full_size;
+    }
+    
+    version_patch_header header;
+    std::string patch_path = get_patch_path(key, version);
+    if (storage_ops.get_file_size(patch_path) < sizeof(header) ||
+        !storage_ops.read_file(patch_path, &header, sizeof(header)) ||
+        header.magic != PATCH_MAGIC) {
+        return 0;
+    }
+    return header.base_size;
+}
+
+bool file_versioning::reconstruct_version(const std::string& key, const file_version_metadata& metadata,
+                                          uint32_t version, std::vector<uint8_t>& data) {
+    // The live file is the current version
+    if (version == metadata.current_version) {
+        size_t size = storage_ops.get_file_size(key);
+        data.resize(size);
+        return size == 0 || storage_ops.read_file(key, data.data(), size);
+    }
+    
+    std::string version_path = get_version_path(key, version);
+    size_t full_size = storage_ops.get_file_size(version_path);
+    if (full_size > 0) {
+        data.resize(full_size);
+        return storage_ops.read_file(version_path, data.data(), full_size);
+    }
+    
+    // Patch of version N applies on top of version N+1
+    std::string patch_path = get_patch_path(key, version);
+    size_t patch_size = storage_ops.get_file_size(patch_path);
+    if (patch_size < sizeof(version_patch_header) || version >= metadata.current_version) {
+        return false;
+    }
+    
+    std::vector<uint8_t> patch(patch_size);
+    if (!storage_ops.read_file(patch_path, patch.data(), patch_size)) {
+        return false;
+    }
+    
+    version_patch_header header;
+    memcpy(&header, patch.data(), sizeof(header));
+    if (header.magic != PATCH_MAGIC || sizeof(header) + header.length > patch_size) {
+        ESP_LOGE(TAG, "Corrupt patch archive: %s", patch_path.c_str());
+        return false;
+    }
+    
+    if (!reconstruct_version(key, metadata, version + 1, data)) {
+        return false;
+    }
+    
+    if (data.size() < header.offset + header.length) {
+        data.resize(header.offset + header.length);
+    }
+    memcpy(data.data() + header.offset, patch.data() + sizeof(header), header.length);
+    data.resize(header.base_size);
+    return true;
 }
 
 bool file_versioning::load_metadata(const std::string& key, file_version_metadata& metadata) {
@@ -365,8 +759,12 @@ bool file_versioning::save_metadata(const std::string& key, const file_version_m
 }
 
 uint32_t file_versioning::calculate_crc32(const void* data, size_t length) const {
+    return update_crc32(0, data, length);
+}
+
+uint32_t file_versioning::update_crc32(uint32_t crc, const void* data, size_t length) const {
     const uint8_t* bytes = (const uint8_t*)data;
-    uint32_t crc = 0xFFFFFFFF;
+    crc = crc ^ 0xFFFFFFFF;
     
     // CRC32 polynomial (IEEE 802.3)
     const uint32_t polynomial = 0xEDB88320;
@@ -385,6 +783,22 @@ uint32_t file_versioning::calculate_crc32(const void* data, size_t length) const
     return crc ^ 0xFFFFFFFF;
 }
 
+bool file_versioning::calculate_file_crc32(const std::string& key, size_t size, uint32_t& crc) {
+    // Stream the file so checksumming a large file needs only a small buffer
+    uint8_t buffer[256];
+    crc = 0;
+    
+    for (size_t offset = 0; offset < size; offset += sizeof(buffer)) {
+        size_t chunk = std::min(sizeof(buffer), size - offset);
+        if (!storage_ops.read_file_range(key, offset, buffer, chunk)) {
+            ESP_LOGE(TAG, "Failed to read %s for checksum", key.c_str());
+            return false;
+        }
+        crc = update_crc32(crc, buffer, chunk);
+    }
+    return true;
+}
+
 bool file_versioning::cleanup_oldest_version(const std::string& key, 
                                              file_version_metadata& metadata) {
     if (metadata.version_count == 0) {
@@ -402,22 +816,23 @@ bool file_versioning::cleanup_oldest_version(const std::string& key,
         }
     }
     
-    // Delete the oldest version file
-    std::string oldest_path = get_version_path(key, oldest_version);
-    if (storage_ops.delete_file(oldest_path)) {
+    // Delete the oldest version file. The slot is dropped even if that
+    // fails: an archive that is already gone must not block newer versions,
+    // and one that cannot be deleted is left to the consistency checker.
+    if (delete_version_files(key, oldest_version)) {
 #if STORAGE_ENABLE_DEBUG_LOGGING
         ESP_LOGD(TAG, "Deleted old version %d of %s", oldest_version, key.c_str());
 #endif
-        
-        // Remove from version list by shifting array
-        for (uint32_t i = oldest_index; i < metadata.version_count - 1; i++) {
-            metadata.versions[i] = metadata.versions[i + 1];
-        }
-        metadata.versions[metadata.version_count - 1] = 0;
-        metadata.version_count--;
-        
-        return true;
+    } else {
+        ESP_LOGW(TAG, "Could not delete old version %d of %s, dropping it", oldest_version, key.c_str());
     }
     
-    return false;
+    // Remove from version list by shifting array
+    for (uint32_t i = oldest_index; i < metadata.version_count - 1; i++) {
+        metadata.versions[i] = metadata.versions[i + 1];
+    }
+    metadata.versions[metadata.version_count - 1] = 0;
+    metadata.version_count--;
+    
+    return true;
 }
\ No newline at end of file
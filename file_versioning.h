@@ -34,6 +34,7 @@ class file_versioning {
         struct storage_callbacks {
             std::function<std::string(const std::string&)> get_full_path;
             std::function<bool(const std::string&, void*, size_t)> read_file;
+            std::function<bool(const std::string&, size_t, void*, size_t)> read_file_range;
             std::function<bool(const std::string&, const void*, size_t)> write_file;
             std::function<bool(const std::string&)> delete_file;
             std::function<size_t(const std::string&)> get_file_size;
@@ -49,6 +50,12 @@ class file_versioning {
 
         ~file_versioning();
 
+        /**
+         * @brief Number of archived versions kept per file, at most STORAGE_MAX_VERSION_HISTORY
+         */
+        void set_max_history(uint32_t versions);
+        uint32_t get_max_history() const { return max_history; }
+
         // Version query methods
         uint32_t get_file_version(const std::string& key);
         bool get_file_version_info(const std::string& key, file_version_info& info);
@@ -62,12 +69,43 @@ class file_versioning {
         bool archive_current_version(const std::string& key);
         bool file_has_changed(const std::string& key, uint32_t last_known_version);
         uint32_t cleanup_old_versions(const std::string& key);
+        uint32_t remove_all_versions(const std::string& key);
+
+        /**
+         * @brief Check a file's metadata against the live file and its archives
+         * @param problem Optional; receives what is wrong
+         * @return true if consistent, or if the file has no metadata
+         */
+        bool check_metadata(const std::string& key, std::string* problem = nullptr);
 
-        // Hook to be called before file write
-        bool on_before_write(const std::string& key, const void* data, size_t size);
+        /**
+         * @brief Repair one versioning artifact left inconsistent by a crash
+         * 
+         * Metadata whose file is gone is removed with its archives; unlisted
+         * archives the history could have produced (the current version, or
+         * one older than every listed version) are removed; metadata that lags
+         * the live file (or is torn) is brought up to it as a new version.
+         * Other archive-like names, and archives with no metadata at all, are
+         * left alone - they may be user keys.
+         * @param path Key of a .meta, .vN or .pN file
+         * @return Number of files removed or rewritten
+         */
+        uint32_t repair_artifact(const std::string& path);
+
+        // Hooks around a full write: the current version is archived before the
+        // data is written, and the metadata moves to the new version only after,
+        // so a crash in between never leaves metadata describing unwritten data
+        bool on_before_write(const std::string& key);
+        bool on_after_write(const std::string& key, const void* data, size_t size);
+
+        // Hooks around a positional write: the previous version is archived as a
+        // reverse patch of the span being overwritten instead of a full copy
+        bool on_before_write_range(const std::string& key, size_t offset, size_t size);
+        bool on_after_write_range(const std::string& key);
 
     private:
         storage_callbacks storage_ops;
+        uint32_t max_history;
 
 #if STORAGE_ENABLE_MUTEX_PROTECTION
         SemaphoreHandle_t versioning_mutex;
@@ -105,11 +143,29 @@ class file_versioning {
             }
         };
 
+        // Reverse patch archive: applying it to version N+1 yields version N
+        struct version_patch_header {
+            uint32_t magic;
+            uint32_t base_size;   // Size of version N
+            uint32_t offset;      // Start of the overwritten span
+            uint32_t length;      // Bytes of version N saved from that span
+        };
+        static const uint32_t PATCH_MAGIC = 0x48435456;  // "VTCH"
+
         // Helper methods
         std::string get_metadata_path(const std::string& key) const;
         std::string get_version_path(const std::string& key, uint32_t version) const;
+        std::string get_patch_path(const std::string& key, uint32_t version) const;
+        bool parse_artifact_path(const std::string& path, std::string& key, uint32_t& version) const;
+        bool record_archived_version(const std::string& key, file_version_metadata& metadata);
+        bool delete_version_files(const std::string& key, uint32_t version);
+        size_t get_version_size(const std::string& key, uint32_t version);
+        bool reconstruct_version(const std::string& key, const file_version_metadata& metadata,
+                                 uint32_t version, std::vector<uint8_t>& data);
         bool load_metadata(const std::string& key, file_version_metadata& metadata);
         bool save_metadata(const std::string& key, const file_version_metadata& metadata);
         uint32_t calculate_crc32(const void* data, size_t length) const;
+        uint32_t update_crc32(uint32_t crc, const void* data, size_t length) const;
+        bool calculate_file_crc32(const std::string& key, size_t size, uint32_t& crc);
         bool cleanup_oldest_version(const std::string& key, file_version_metadata& metadata);
 };
\ No newline at end of file
@@ -0,0 +1,37 @@
+#include "key_fanout.h"
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+
+std::string key_fanout::map_key(const std::string& key) {
+    size_t last_slash = key.rfind('/');
+    size_t name_start = (last_slash == std::string::npos) ? 0 : last_slash + 1;
+    if (name_start >= key.length()) {
+        return key;
+    }
+    
+    uint32_t h = hash(key.c_str() + name_start, key.length() - name_start);
+    
+    char buckets[10];
+    snprintf(buckets, sizeof(buckets), "%c%02x/%c%02x/",
+             STORAGE_FANOUT_MARKER, (unsigned)(h & 0xFF),
+             STORAGE_FANOUT_MARKER, (unsigned)((h >> 8) & 0xFF));
+    
+    return key.substr(0, name_start) + buckets + key.substr(name_start);
+}
+
+bool key_fanout::is_bucket(const char* name) {
+    return name[0] == STORAGE_FANOUT_MARKER &&
+           isxdigit((unsigned char)name[1]) &&
+           isxdigit((unsigned char)name[2]) &&
+           name[3] == '\0';
+}
+
+uint32_t key_fanout::hash(const char* data, size_t length) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        h ^= (uint8_t)data[i];
+        h *= 16777619u;
+    }
+    return h;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "storage_config.h"
+#include <string>
+#include <cstdint>
+
+/**
+ * @brief Hashed two-level directory fan-out for large flat key spaces
+ * 
+ * Maps a logical key "dir/name" to the physical key "dir/@ab/@cd/name", where
+ * ab and cd are taken from a hash of the name. Each directory then holds at
+ * most 256 buckets and keys spread evenly below them, keeping LittleFS lookups
+ * and listings short. Bucket directories are recognised by the marker
+ * character and skipped transparently by the listing engine, so logical names
+ * must not look like buckets (marker followed by two hex digits).
+ */
+class key_fanout {
+    public:
+        /**
+         * @brief Physical key for a logical key
+         */
+        static std::string map_key(const std::string& key);
+
+        /**
+         * @brief Whether a directory entry name is a fan-out bucket
+         */
+        static bool is_bucket(const char* name);
+
+        /**
+         * @brief FNV-1a hash of a key name
+         */
+        static uint32_t hash(const char* data, size_t length);
+};
@@ -0,0 +1,222 @@
+#include "metadata_index.h"
+#include "esp_log.h"
+#include <cstdio>
+#include <errno.h>
+#include <vector>
+
+static const char* TAG = "metadata_index";
+
+metadata_index::metadata_index() : _valid(false) {
+}
+
+bool metadata_index::lookup(const std::string& key, entry& info) const {
+    auto it = _entries.find(key);
+    if (it == _entries.end()) {
+        return false;
+    }
+    info = it->second;
+    return true;
+}
+
+void metadata_index::put(const std::string& key, uint32_t size, bool is_directory) {
+    _entries[key] = {size, is_directory};
+}
+
+void metadata_index::erase(const std::string& key) {
+    _entries.erase(key);
+}
+
+void metadata_index::erase_tree(const std::string& dir) {
+    if (dir.empty()) {
+        _entries.clear();
+        return;
+    }
+    
+    std::string prefix = dir + "/";
+    for (auto it = _entries.begin(); it != _entries.end();) {
+        if (it->first == dir || it->first.compare(0, prefix.length(), prefix) == 0) {
+            it = _entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void metadata_index::rename(const std::string& old_key, const std::string& new_key) {
+    auto it = _entries.find(old_key);
+    if (it == _entries.end()) {
+        return;
+    }
+    
+    entry moved = it->second;
+    _entries.erase(it);
+    _entries[new_key] = moved;
+    
+    if (!moved.is_directory) {
+        return;
+    }
+    
+    // Move everything below a renamed directory
+    std::string old_prefix = old_key + "/";
+    std::vector<std::pair<std::string, entry>> children;
+    for (auto child = _entries.begin(); child != _entries.end();) {
+        if (child->first.compare(0, old_prefix.length(), old_prefix) == 0) {
+            children.push_back({new_key + "/" + child->first.substr(old_prefix.length()), child->second});
+            child = _entries.erase(child);
+        } else {
+            ++child;
+        }
+    }
+    for (auto& child : children) {
+        _entries[child.first] = child.second;
+    }
+}
+
+void metadata_index::clear() {
+    _entries.clear();
+}
+
+// ========== Snapshot Persistence ==========
+
+bool metadata_index::save(const std::string& path) const {
+    // Written beside the snapshot and renamed over it, so a save cut short
+    // never leaves a half-written file under the snapshot's name
+    std::string temp_path = path + ".tmp";
+    FILE* f = fopen(temp_path.c_str(), "wb");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open snapshot for writing: %s", temp_path.c_str());
+        return false;
+    }
+    
+    // Header goes in first as a placeholder and is rewritten once the body CRC is known
+    snapshot_header header = {SNAPSHOT_MAGIC, SNAPSHOT_FORMAT, (uint32_t)_entries.size(), 0, 0};
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    
+    for (auto it = _entries.begin(); ok && it != _entries.end(); ++it) {
+        uint16_t key_length = it->first.length();
+        uint8_t is_directory = it->second.is_directory ? 1 : 0;
+        
+        ok = fwrite(&key_length, sizeof(key_length), 1, f) == 1 &&
+             fwrite(it->first.data(), 1, key_length, f) == key_length &&
+             fwrite(&it->second.size, sizeof(it->second.size), 1, f) == 1 &&
+             fwrite(&is_directory, sizeof(is_directory), 1, f) == 1;
+        
+        header.body_crc = _update_crc32(header.body_crc, &key_length, sizeof(key_length));
+        header.body_crc = _update_crc32(header.body_crc, it->first.data(), key_length);
+        header.body_crc = _update_crc32(header.body_crc, &it->second.size, sizeof(it->second.size));
+        header.body_crc = _update_crc32(header.body_crc, &is_directory, sizeof(is_directory));
+        header.body_size += sizeof(key_length) + key_length + sizeof(it->second.size) + sizeof(is_directory);
+    }
+    
+    ok = ok && fseek(f, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, f) == 1;
+    ok = (fclose(f) == 0) && ok;
+    
+    // SPIFFS will not rename over an existing file
+    if (!ok || (remove(path.c_str()) != 0 && errno != ENOENT) || ::rename(temp_path.c_str(), path.c_str()) != 0) {
+        ESP_LOGE(TAG, "Failed to write snapshot: %s", path.c_str());
+        remove(temp_path.c_str());
+        return false;
+    }
+    
+    ESP_LOGD(TAG, "Saved %u entries (%u bytes) to %s",
+             (unsigned)header.count, (unsigned)header.body_size, path.c_str());
+    return true;
+}
+
+bool metadata_index::load(const std::string& path) {
+    _entries.clear();
+    _valid = false;
+    
+    // Left behind only by a save that never finished
+    remove((path + ".tmp").c_str());
+    
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    
+    snapshot_header header;
+    if (fread(&header, sizeof(header), 1, f) != 1 ||
+        header.magic != SNAPSHOT_MAGIC || header.format != SNAPSHOT_FORMAT) {
+        ESP_LOGW(TAG, "Ignoring snapshot with bad header: %s", path.c_str());
+        fclose(f);
+        return false;
+    }
+    
+    // The count sizes an allocation, so it has to fit in the bytes actually there
+    long file_size = -1;
+    if (fseek(f, 0, SEEK_END) == 0) {
+        file_size = ftell(f);
+    }
+    if (file_size < (long)sizeof(header) || fseek(f, sizeof(header), SEEK_SET) != 0 ||
+        header.body_size != (uint32_t)(file_size - sizeof(header)) ||
+        header.count > header.body_size / MIN_ENTRY_SIZE) {
+        ESP_LOGW(TAG, "Ignoring snapshot with bad header: %s", path.c_str());
+        fclose(f);
+        return false;
+    }
+    
+    _entries.reserve(header.count);
+    
+    uint32_t crc = 0;
+    uint32_t body_size = 0;
+    bool ok = true;
+    std::string key;
+    
+    for (uint32_t i = 0; ok && i < header.count; i++) {
+        uint16_t key_length = 0;
+        entry info;
+        uint8_t is_directory = 0;
+        
+        ok = fread(&key_length, sizeof(key_length), 1, f) == 1;
+        if (ok) {
+            key.resize(key_length);
+            ok = fread(&key[0], 1, key_length, f) == key_length &&
+                 fread(&info.size, sizeof(info.size), 1, f) == 1 &&
+                 fread(&is_directory, sizeof(is_directory), 1, f) == 1;
+        }
+        if (!ok) {
+            break;
+        }
+        
+        crc = _update_crc32(crc, &key_length, sizeof(key_length));
+        crc = _update_crc32(crc, key.data(), key_length);
+        crc = _update_crc32(crc, &info.size, sizeof(info.size));
+        crc = _update_crc32(crc, &is_directory, sizeof(is_directory));
+        body_size += sizeof(key_length) + key_length + sizeof(info.size) + sizeof(is_directory);
+        
+        info.is_directory = is_directory != 0;
+        _entries[key] = info;
+    }
+    fclose(f);
+    
+    if (!ok || crc != header.body_crc || body_size != header.body_size) {
+        ESP_LOGW(TAG, "Ignoring corrupt snapshot: %s", path.c_str());
+        _entries.clear();
+        return false;
+    }
+    
+    _valid = true;
+    return true;
+}
+
+// ========== Private Helper Methods ==========
+
+uint32_t metadata_index::_update_crc32(uint32_t crc, const void* data, size_t length) {
+    // CRC32 polynomial (IEEE 802.3), same as file_versioning
+    const uint8_t* bytes = (const uint8_t*)data;
+    crc = crc ^ 0xFFFFFFFF;
+    
+    for (size_t i = 0; i < length; i++) {
+        crc ^= bytes[i];
+        for (int j = 0; j < 8; j++) {
+            if (crc & 1) {
+                crc = (crc >> 1) ^ 0xEDB88320;
+            } else {
+                crc = crc >> 1;
+            }
+        }
+    }
+    
+    return crc ^ 0xFFFFFFFF;
+}
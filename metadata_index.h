@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+
+/**
+ * @brief In-RAM index of file existence and sizes with a persisted snapshot
+ * 
+ * Answers exists()/file_size() without touching the filesystem once it is
+ * valid. The owner keeps it current on every mutation, saves a checksummed
+ * snapshot at clean unmount and loads it at mount, so warm starts do not need
+ * to walk the filesystem. Not thread safe - the owner serializes access.
+ */
+class metadata_index {
+    public:
+        struct entry {
+            uint32_t size;
+            bool is_directory;
+        };
+
+        metadata_index();
+
+        /**
+         * @brief Whether the index reflects the whole filesystem
+         * 
+         * While invalid (before load or during a rebuild) mutations are still
+         * recorded, but lookups must not be trusted.
+         */
+        bool is_valid() const { return _valid; }
+        void set_valid(bool valid) { _valid = valid; }
+
+        bool lookup(const std::string& key, entry& info) const;
+        void put(const std::string& key, uint32_t size, bool is_directory);
+        void erase(const std::string& key);
+        void erase_tree(const std::string& dir);
+        void rename(const std::string& old_key, const std::string& new_key);
+        void clear();
+        size_t size() const { return _entries.size(); }
+
+        /**
+         * @brief Write a checksummed snapshot to an absolute path
+         * 
+         * The snapshot is written to path + ".tmp" first and renamed into place.
+         */
+        bool save(const std::string& path) const;
+
+        /**
+         * @brief Load a snapshot; on success the index becomes valid
+         * @return false if the snapshot is missing, truncated or corrupt
+         */
+        bool load(const std::string& path);
+
+    private:
+        struct snapshot_header {
+            uint32_t magic;
+            uint32_t format;
+            uint32_t count;
+            uint32_t body_size;
+            uint32_t body_crc;
+        };
+        static const uint32_t SNAPSHOT_MAGIC = 0x58444e49;  // "INDX"
+        static const uint32_t SNAPSHOT_FORMAT = 1;
+        // Key length, size and directory flag of an entry with an empty key
+        static const uint32_t MIN_ENTRY_SIZE = sizeof(uint16_t) + sizeof(uint32_t) + sizeof(uint8_t);
+
+        std::unordered_map<std::string, entry> _entries;
+        bool _valid;
+
+        static uint32_t _update_crc32(uint32_t crc, const void* data, size_t length);
+};
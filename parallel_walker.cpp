@@ -0,0 +1,243 @@
+#include "parallel_walker.h"
+#include "key_fanout.h"
+#include "storage_glob.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include <dirent.h>
+#include <cstring>
+#include <thread>
+
+#if !CONFIG_IDF_TARGET_LINUX
+#include "freertos/FreeRTOS.h"
+#include "esp_pthread.h"
+#endif
+
+static const char* TAG = "parallel_walker";
+
+parallel_walker::parallel_walker(const std::string& base_path, size_t num_workers)
+    : _base_path(base_path), _num_workers(num_workers > 0 ? num_workers : 1),
+      _visitor(nullptr), _pending(0), _queued(0), _stop(false), _files_visited(0), _dirs_visited(0) {
+    
+    for (size_t i = 0; i < _num_workers; i++) {
+        _queues.push_back(std::make_unique<work_queue>());
+    }
+}
+
+bool parallel_walker::run(const file_visitor_t& visitor, const walk_options_t& options) {
+    if (!visitor) {
+        return false;
+    }
+    
+    _options = options;
+    _options.prefix = dir_walker::normalize_prefix(_options.prefix);
+    if (_options.prefix.empty() && !_options.pattern.empty()) {
+        _options.pattern = dir_walker::normalize_prefix(_options.pattern);
+        _options.prefix = storage_glob::literal_prefix(_options.pattern);
+    }
+    _options.attributes |= STORAGE_ATTR_TYPE;
+    _visitor = &visitor;
+    _stop = false;
+    _files_visited = 0;
+    _dirs_visited = 0;
+    
+    _pending = 1;
+    _queued = 1;
+    std::string start_dir = dir_walker::start_directory(_options.prefix);
+    _queues[0]->dirs.push_back({start_dir, start_dir});
+    
+    std::vector<std::thread> workers;
+    workers.reserve(_num_workers - 1);
+    
+#if !CONFIG_IDF_TARGET_LINUX
+    // Restored afterwards, so threads the caller creates later keep its settings
+    esp_pthread_cfg_t caller_cfg;
+    bool caller_has_cfg = esp_pthread_get_cfg(&caller_cfg) == ESP_OK;
+    
+    esp_pthread_cfg_t cfg = esp_pthread_get_default_config();
+    cfg.stack_size = STORAGE_PARALLEL_WALK_STACK_SIZE;
+    cfg.thread_name = "storage_walk";
+#endif
+    
+    // The calling task acts as worker 0
+    for (size_t i = 1; i < _num_workers; i++) {
+#if !CONFIG_IDF_TARGET_LINUX
+        cfg.pin_to_core = i % portNUM_PROCESSORS;
+        esp_pthread_set_cfg(&cfg);
+#endif
+        workers.emplace_back(&parallel_walker::_worker, this, i);
+    }
+    
+#if !CONFIG_IDF_TARGET_LINUX
+    if (!caller_has_cfg) {
+        caller_cfg = esp_pthread_get_default_config();
+    }
+    esp_pthread_set_cfg(&caller_cfg);
+#endif
+    
+    _worker(0);
+    
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    // Drop whatever was left behind by an early stop
+    for (auto& queue : _queues) {
+        queue->dirs.clear();
+    }
+    _queued = 0;
+    _visitor = nullptr;
+    
+#if STORAGE_ENABLE_DEBUG_LOGGING
+    ESP_LOGD(TAG, "Walked %zu directories, %zu files with %zu workers",
+             _dirs_visited.load(), _files_visited.load(), _num_workers);
+#endif
+    return !_stop;
+}
+
+// ========== Private Helper Methods ==========
+
+void parallel_walker::_worker(size_t index) {
+    work_item dir;
+    
+    while (!_stop) {
+        if (_take_work(index, dir)) {
+            _process_directory(index, dir);
+            if (--_pending == 0) {
+                _wake_idle(true);
+            }
+            continue;
+        }
+        
+        // Nothing to steal: sleep until a directory is queued or the walk ends
+        // rather than spinning, which would starve lower-priority tasks
+        std::unique_lock<std::mutex> lock(_idle_lock);
+        _idle_cv.wait(lock, [this] { return _stop || _pending == 0 || _queued > 0; });
+        if (_pending == 0) {
+            break;
+        }
+    }
+}
+
+void parallel_walker::_wake_idle(bool all) {
+    // Taking the lock orders the state change before any waiter's predicate check
+    {
+        std::lock_guard<std::mutex> guard(_idle_lock);
+    }
+    if (all) {
+        _idle_cv.notify_all();
+    } else {
+        _idle_cv.notify_one();
+    }
+}
+
+bool parallel_walker::_take_work(size_t index, work_item& dir) {
+    // Own queue first, newest entry (depth-first, cache friendly)
+    {
+        work_queue& own = *_queues[index];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.dirs.empty()) {
+            dir = std::move(own.dirs.back());
+            own.dirs.pop_back();
+            _queued--;
+            return true;
+        }
+    }
+    
+    // Steal the oldest entry from another worker - usually the largest subtree
+    for (size_t i = 1; i < _num_workers; i++) {
+        work_queue& victim = *_queues[(index + i) % _num_workers];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.dirs.empty()) {
+            dir = std::move(victim.dirs.front());
+            victim.dirs.pop_front();
+            _queued--;
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+void parallel_walker::_push_work(size_t index, work_item&& dir) {
+    _pending++;
+    {
+        work_queue& own = *_queues[index];
+        std::lock_guard<std::mutex> guard(own.lock);
+        own.dirs.push_back(std::move(dir));
+        _queued++;
+    }
+    _wake_idle(false);
+}
+
+void parallel_walker::_process_directory(size_t index, const work_item& dir) {
+    DIR* handle = opendir(_get_full_path(dir.path).c_str());
+    if (!handle) {
+        ESP_LOGD(TAG, "Failed to open directory: %s", dir.path.c_str());
+        return;
+    }
+    
+    _dirs_visited++;
+    
+    struct dirent* entry;
+    while (!_stop && (entry = readdir(handle)) != NULL) {
+        // Skip . and ..
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0 ||
+            dir_walker::is_reserved(dir.path, entry->d_name)) {
+            continue;
+        }
+        
+        std::string physical = dir_walker::join(dir.path, entry->d_name);
+        
+        // Buckets are invisible: their contents belong to the parent directory
+        if (_options.fanout && key_fanout::is_bucket(entry->d_name)) {
+            _push_work(index, {physical, dir.logical});
+            continue;
+        }
+        
+        std::string path = dir_walker::join(dir.logical, entry->d_name);
+        
+        bool matches = dir_walker::matches_prefix(path, _options.prefix) &&
+                       (_options.pattern.empty() || storage_glob::match(_options.pattern, path));
+        bool may_descend = dir_walker::may_contain_prefix(path, _options.prefix) &&
+                           (_options.pattern.empty() || storage_glob::may_match_below(_options.pattern, path));
+        if (!matches && !may_descend) {
+            continue;
+        }
+        
+        file_info_t info;
+        if (!dir_walker::read_attributes(_get_full_path(physical), entry, _options.attributes, info)) {
+            continue;
+        }
+        
+        if (info.is_directory) {
+            if (may_descend) {
+                _push_work(index, {physical, path});
+            }
+            continue;
+        }
+        
+        if (!matches) {
+            continue;
+        }
+        
+        info.path = path;
+        if (_options.filter && !_options.filter(info)) {
+            continue;
+        }
+        
+        _files_visited++;
+        if (!(*_visitor)(info)) {
+            _stop = true;
+            _wake_idle(true);
+        }
+    }
+    
+    closedir(handle);
+}
+
+std::string parallel_walker::_get_full_path(const std::string& path) const {
+    if (path.empty()) {
+        return _base_path;
+    }
+    return _base_path + "/" + path;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "dir_walker.h"
+#include "storage_config.h"
+#include <string>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+/**
+ * @brief Multi-threaded recursive directory walker
+ * 
+ * Directories are distributed over per-worker work-stealing queues: each
+ * worker pushes the subdirectories it discovers onto its own queue and pops
+ * from the back, while idle workers steal from the front of other queues.
+ * Workers with nothing to steal sleep until work is queued or the walk ends.
+ * On ESP32 the workers are pinned round-robin across cores; on the host
+ * (linux target) they are plain threads.
+ */
+class parallel_walker {
+    public:
+        /**
+         * @brief Create a walker rooted at base_path
+         * @param base_path Filesystem mount point
+         * @param num_workers Number of worker threads (at least 1)
+         */
+        explicit parallel_walker(const std::string& base_path,
+                                 size_t num_workers = STORAGE_PARALLEL_WALK_WORKERS);
+
+        /**
+         * @brief Visit every file selected by options
+         * 
+         * The visitor (and options.filter) are called concurrently from all
+         * workers and must be thread safe. Returning false stops all workers
+         * as soon as possible. Directories are never reported and the entry
+         * type is always resolved; options.recursive is ignored.
+         * @return true if the walk ran to completion
+         */
+        bool run(const file_visitor_t& visitor, const walk_options_t& options = walk_options_t());
+
+        size_t get_files_visited() const { return _files_visited.load(); }
+        size_t get_directories_visited() const { return _dirs_visited.load(); }
+
+    private:
+        struct work_item {
+            std::string path;     // Physical directory relative to the base path
+            std::string logical;  // Same directory with fan-out buckets removed
+        };
+
+        struct work_queue {
+            std::mutex lock;
+            std::deque<work_item> dirs;
+        };
+
+        std::string _base_path;
+        size_t _num_workers;
+        std::vector<std::unique_ptr<work_queue>> _queues;
+        walk_options_t _options;
+        const file_visitor_t* _visitor;
+
+        std::atomic<size_t> _pending;  // Directories queued or being processed
+        std::atomic<size_t> _queued;   // Directories waiting in a queue
+        std::atomic<bool> _stop;
+        std::mutex _idle_lock;
+        std::condition_variable _idle_cv;
+        std::atomic<size_t> _files_visited;
+        std::atomic<size_t> _dirs_visited;
+
+        void _worker(size_t index);
+        bool _take_work(size_t index, work_item& dir);
+        void _push_work(size_t index, work_item&& dir);
+        void _wake_idle(bool all);
+        void _process_directory(size_t index, const work_item& dir);
+        std::string _get_full_path(const std::string& path) const;
+};
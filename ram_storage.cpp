@@ -0,0 +1,381 @@
+#include "ram_storage.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include <cstring>
+
+static const char* TAG = "ram_storage";
+
+ram_storage::ram_storage(size_t budget_bytes)
+    : _budget(budget_bytes), _used(0), _is_mounted(false), _mutex(nullptr) {
+    _mutex = xSemaphoreCreateMutex();
+    if (_mutex == nullptr) {
+        ESP_LOGE(TAG, "Failed to create RAM storage mutex");
+    }
+}
+
+ram_storage::~ram_storage() {
+    if (_mutex != nullptr) {
+        vSemaphoreDelete(_mutex);
+    }
+}
+
+// ========== Helper Methods ==========
+
+std::string ram_storage::_normalize_key(const std::string& key) {
+    size_t start = key.find_first_not_of('/');
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = key.find_last_not_of('/');
+    return key.substr(start, end - start + 1);
+}
+
+void ram_storage::_add_parents(const std::string& key) {
+    size_t slash = key.find('/');
+    while (slash != std::string::npos) {
+        _directories.insert(key.substr(0, slash));
+        slash = key.find('/', slash + 1);
+    }
+}
+
+bool ram_storage::_store(const std::string& key, const void* data, size_t data_size) {
+    if (key.empty() || _directories.count(key)) {
+        ESP_LOGE(TAG, "Invalid file key: %s", key.c_str());
+        return false;
+    }
+    
+    auto it = _files.find(key);
+    size_t old_size = (it != _files.end()) ? it->second.size() : 0;
+    
+    if (_budget > 0 && _used - old_size + data_size > _budget) {
+        ESP_LOGE(TAG, "Write of %zu bytes to %s exceeds budget (%zu of %zu used)",
+                 data_size, key.c_str(), _used, _budget);
+        return false;
+    }
+    
+    std::vector<uint8_t>& contents = _files[key];
+    contents.assign((const uint8_t*)data, (const uint8_t*)data + data_size);
+    contents.shrink_to_fit();
+    _used = _used - old_size + data_size;
+    
+    _add_parents(key);
+    return true;
+}
+
+// ========== Public Interface Methods ==========
+
+bool ram_storage::begin() {
+    return mount(STORAGE_FORMAT_IF_MOUNT_FAILS);
+}
+
+bool ram_storage::mount(bool /*format_on_fail*/) {
+    mutex_guard guard(_mutex);
+    
+    // Contents survive unmount/mount; only format() or destruction drops them
+    _is_mounted = true;
+    return true;
+}
+
+bool ram_storage::unmount() {
+    mutex_guard guard(_mutex);
+    
+    _is_mounted = false;
+    return true;
+}
+
+bool ram_storage::format() {
+    mutex_guard guard(_mutex);
+    
+    if (!_is_mounted) {
+        ESP_LOGE(TAG, "Storage not mounted, cannot format");
+        return false;
+    }
+    
+    _files.clear();
+    _directories.clear();
+    _used = 0;
+    return true;
+}
+
+bool ram_storage::read_file(const std::string& key, void* data, size_t data_size) {
+    mutex_guard guard(_mutex);
+    
+    if (!_is_mounted || !data) {
+        return false;
+    }
+    
+    auto it = _files.find(_normalize_key(key));
+    if (it == _files.end()) {
+        ESP_LOGE(TAG, "File not found: %s", key.c_str());
+        return false;
+    }
+    
+    // Same contract as storage_esp: a short file fills part of the buffer
+    size_t length = std::min(data_size, it->second.size());
+    if (length == 0 && data_size > 0) {
+        ESP_LOGE(TAG, "Failed to read any data from %s", key.c_str());
+        return false;
+    }
+    
+    memcpy(data, it->second.data(), length);
+    return true;
+}
+
+bool ram_storage::write_file(const std::string& key, const void* data, size_t data_size) {
+    mutex_guard guard(_mutex);
+    
+    if (!_is_mounted || !data) {
+        return false;
+    }
+    
+    return _store(_normalize_key(key), data, data_size);
+}
+
+bool ram_storage::erase_file(const std::string& key) {
+    mutex_guard guard(_mutex);
+    
+    if (!_is_mounted) {
+        return false;
+    }
+    
+    auto it = _files.find(_normalize_key(key));
+    if (it == _files.end()) {
+        ESP_LOGE(TAG, "Failed to delete file: %s", key.c_str());
+        return false;
+    }
+    
+    _used -= it->second.size();
+    _files.erase(it);
+    return true;
+}
+
+size_t ram_storage::file_size(const std::string& key) {
+    mutex_guard guard(_mutex);
+    
+    if (!_is_mounted) {
+        return 0;
+    }
+    
+    auto it = _files.find(_normalize_key(key));
+    return it != _files.end() ? it->second.size() : 0;
+}
+
+bool ram_storage::exists(const std::string& key) {
+    mutex_guard guard(_mutex);
+    
+    if (!_is_mounted) {
+        return false;
+    }
+    
+    std::string normalized = _normalize_key(key);
+    return _files.count(normalized) > 0 || _directories.count(normalized) > 0;
+}
+
+size_t ram_storage::total_size() {
+    mutex_guard guard(_mutex);
+    
+    if (_budget > 0) {
+        return _budget;
+    }
+    // Unbounded: whatever the heap could still hold on top of what is stored
+    return _used + esp_get_free_heap_size();
+}
+
+size_t ram_storage::used_size() {
+    mutex_guard guard(_mutex);
+    return _used;
+}
+
+bool ram_storage::list_all_files(std::vector<file_info_t>& files) {
+    mutex_guard guard(_mutex);
+    
+    if (!_is_mounted) {
+        return false;
+    }
+    
+    for (const auto& entry : _files) {
+        files.push_back({entry.first, entry.second.size(), false});
+    }
+    return true;
+}
+
+// ========== Advanced File Operations ==========
+
+bool ram_storage::rename_file(const std::string& old_key, const std::string& new_key) {
+    mutex_guard guard(_mutex);
+    
+    if (!_is_mounted) {
+        return false;
+    }
+    
+    std::string old_name = _normalize_key(old_key);
+    std::string new_name = _normalize_key(new_key);
+    if (new_name.empty()) {
+        return false;
+    }
+    if (old_name == new_name) {
+        return _files.count(old_name) != 0 || _directories.count(old_name) != 0;
+    }
+    
+    auto it = _files.find(old_name);
+    if (it != _files.end()) {
+        auto existing = _files.find(new_name);
+        if (existing != _files.end()) {
+            _used -= existing->second.size();
+        }
+        std::vector<uint8_t> contents = std::move(it->second);
+        _files.erase(it);
+        _files[new_name] = std::move(contents);
+        _add_parents(new_name);
+        return true;
+    }
+    
+    if (_directories.count(old_name) == 0) {
+        ESP_LOGE(TAG, "Failed to rename file: %s -> %s", old_key.c_str(), new_key.c_str());
+        return false;
+    }
+    
+    // Directory: move it and everything below it
+    std::string old_prefix = old_name + "/";
+    if (new_name.compare(0, old_prefix.length(), old_prefix) == 0) {
+        ESP_LOGE(TAG, "Cannot move directory into itself: %s -> %s", old_key.c_str(), new_key.c_str());
+        return false;
+    }
+    for (auto file = _files.lower_bound(old_prefix); file != _files.end() &&
+         file->first.compare(0, old_prefix.length(), old_prefix) == 0;) {
+        std::string moved = new_name + "/" + file->first.substr(old_prefix.length());
+        auto existing = _files.find(moved);
+        if (existing != _files.end()) {
+            _used -= existing->second.size();
+        }
+        _files[moved] = std::move(file->second);
+        file = _files.erase(file);
+    }
+    
+    std::vector<std::string> moved_dirs = {new_name};
+    _directories.erase(old_name);
+    for (auto dir = _directories.lower_bound(old_prefix); dir != _directories.end() &&
+         dir->compare(0, old_prefix.length(), old_prefix) == 0;) {
+        moved_dirs.push_back(new_name + "/" + dir->substr(old_prefix.length()));
+        dir = _directories.erase(dir);
+    }
+    _directories.insert(moved_dirs.begin(), moved_dirs.end());
+    _add_parents(new_name);
+    return true;
+}
+
+// ========== Directory Operations ==========
+
+bool ram_storage::create_directory(const std::string& path) {
+    mutex_guard guard(_mutex);
+    
+    if (!_is_mounted) {
+        return false;
+    }
+    
+    std::string normalized = _normalize_key(path);
+    if (normalized.empty()) {
+        return true;
+    }
+    if (_files.count(normalized)) {
+        ESP_LOGE(TAG, "Failed to create directory: %s", path.c_str());
+        return false;
+    }
+    
+    _directories.insert(normalized);
+    _add_parents(normalized);
+    return true;
+}
+
+bool ram_storage::list_directory(const std::string& path, std::vector<file_info_t>& files) {
+    mutex_guard guard(_mutex);
+    
+    if (!_is_mounted) {
+        return false;
+    }
+    
+    std::string dir = _normalize_key(path);
+    if (!dir.empty() && _directories.count(dir) == 0) {
+        ESP_LOGE(TAG, "Failed to open directory: %s", path.c_str());
+        return false;
+    }
+    
+    // Direct children only, full keys as storage_esp::list_all_files reports them
+    std::string prefix = dir.empty() ? "" : dir + "/";
+    for (auto it = _directories.lower_bound(prefix); it != _directories.end() &&
+         it->compare(0, prefix.length(), prefix) == 0; ++it) {
+        if (it->find('/', prefix.length()) == std::string::npos) {
+            files.push_back({*it, 0, true});
+        }
+    }
+    for (auto it = _files.lower_bound(prefix); it != _files.end() &&
+         it->first.compare(0, prefix.length(), prefix) == 0; ++it) {
+        if (it->first.find('/', prefix.length()) == std::string::npos) {
+            files.push_back({it->first, it->second.size(), false});
+        }
+    }
+    return true;
+}
+
+// ========== Snapshots ==========
+
+bool ram_storage::snapshot_to(storage_interface& target, const std::string& prefix) {
+    mutex_guard guard(_mutex);
+    
+    if (!_is_mounted) {
+        return false;
+    }
+    
+    bool ok = true;
+    for (const auto& entry : _files) {
+        if (!target.write_file(prefix + entry.first, entry.second.data(), entry.second.size())) {
+            ESP_LOGE(TAG, "Snapshot failed for %s", entry.first.c_str());
+            ok = false;
+        }
+    }
+    
+#if STORAGE_ENABLE_DEBUG_LOGGING
+    ESP_LOGI(TAG, "Snapshot of %u files (%zu bytes) %s", (unsigned)_files.size(), _used,
+             ok ? "written" : "incomplete");
+#endif
+    return ok;
+}
+
+bool ram_storage::restore_from(storage_interface& source, const std::string& prefix) {
+    std::vector<file_info_t> listing;
+    if (!source.list_all_files(listing)) {
+        return false;
+    }
+    
+    mutex_guard guard(_mutex);
+    
+    if (!_is_mounted) {
+        return false;
+    }
+    
+    _files.clear();
+    _directories.clear();
+    _used = 0;
+    
+    std::string normalized_prefix = _normalize_key(prefix);
+    if (!normalized_prefix.empty() && prefix.back() == '/') {
+        normalized_prefix += "/";
+    }
+    
+    bool ok = true;
+    std::vector<uint8_t> buffer;
+    for (const auto& info : listing) {
+        std::string key = _normalize_key(info.path);
+        if (info.is_directory || key.compare(0, normalized_prefix.length(), normalized_prefix) != 0) {
+            continue;
+        }
+        
+        buffer.resize(info.size);
+        if ((info.size > 0 && !source.read_file(info.path, buffer.data(), info.size)) ||
+            !_store(key.substr(normalized_prefix.length()), buffer.data(), info.size)) {
+            ESP_LOGE(TAG, "Restore failed for %s", info.path.c_str());
+            ok = false;
+        }
+    }
+    return ok;
+}
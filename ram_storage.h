@@ -0,0 +1,95 @@
+#pragma once
+
+#include "interface/storage_interface.h"
+#include "storage_config.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <cstdint>
+
+/**
+ * @brief In-memory storage_interface backend
+ *
+ * Holds files as byte vectors and directories as a set of paths, with the same
+ * key rules as storage_esp: leading slashes are ignored and writing a key
+ * creates its parent directories. Contents are lost on reset unless
+ * snapshot_to() copies them to a persistent backend first. Also serves as a
+ * zero-I/O baseline when measuring the layers above storage.
+ */
+class ram_storage : public storage_interface
+{
+    public:
+        /**
+         * @param budget_bytes Limit on file contents in bytes, 0 for no limit
+         */
+        explicit ram_storage(size_t budget_bytes = STORAGE_RAM_DEFAULT_BUDGET);
+        ~ram_storage();
+
+        // ===== storage_interface implementation =====
+        bool begin() override;
+        bool read_file(const std::string& key, void* data, size_t data_size) override;
+        bool write_file(const std::string& key, const void* data, size_t data_size) override;
+        bool erase_file(const std::string& key) override;
+        size_t file_size(const std::string& key) override;
+        bool exists(const std::string& key) override;
+        size_t total_size() override;
+        size_t used_size() override;
+        bool mount(bool format_on_fail = STORAGE_FORMAT_IF_MOUNT_FAILS) override;
+        bool unmount() override;
+        bool format() override;
+        bool list_all_files(std::vector<file_info_t>& files) override;
+        bool get_is_mounted() const override { return _is_mounted; }
+
+        // ===== Advanced file operations =====
+        bool rename_file(const std::string& old_key, const std::string& new_key);
+
+        // ===== Directory operations =====
+        bool create_directory(const std::string& path);
+        bool list_directory(const std::string& path, std::vector<file_info_t>& files);
+
+        // ===== Snapshots =====
+        /**
+         * @brief Copy every file to another backend, e.g. a storage_esp partition
+         * @param prefix Key prefix prepended on the target
+         */
+        bool snapshot_to(storage_interface& target, const std::string& prefix = "");
+
+        /**
+         * @brief Replace the contents with the files of another backend
+         * @param prefix Only keys starting with it are loaded, with it stripped
+         */
+        bool restore_from(storage_interface& source, const std::string& prefix = "");
+
+        // ===== Getters =====
+        size_t get_budget() const { return _budget; }
+        void set_budget(size_t budget_bytes) { _budget = budget_bytes; }
+
+    private:
+        std::map<std::string, std::vector<uint8_t>> _files;
+        std::set<std::string> _directories;
+        size_t _budget;
+        size_t _used;
+        bool _is_mounted;
+
+        SemaphoreHandle_t _mutex;
+
+        class mutex_guard {
+        public:
+            explicit mutex_guard(SemaphoreHandle_t& mutex) : m_mutex(mutex) {
+                xSemaphoreTake(m_mutex, STORAGE_MUTEX_TIMEOUT_MS);
+            }
+            ~mutex_guard() {
+                xSemaphoreGive(m_mutex);
+            }
+        private:
+            SemaphoreHandle_t& m_mutex;
+        };
+
+        // ===== Internal helpers =====
+        static std::string _normalize_key(const std::string& key);
+        void _add_parents(const std::string& key);
+        bool _store(const std::string& key, const void* data, size_t data_size);
+};
@@ -29,6 +29,11 @@
 #define STORAGE_FORMAT_IF_MOUNT_FAILS true
 #define STORAGE_MAX_FILES 10
 
+// Background mount: begin() returns at once and the first storage call waits for the mount
+#define STORAGE_BACKGROUND_MOUNT false
+#define STORAGE_MOUNT_TASK_STACK_SIZE 4096
+#define STORAGE_MOUNT_TASK_PRIORITY 5
+
 // Default mount points for different filesystems
 #define STORAGE_SPIFFS_BASE_PATH "/spiffs"
 #define STORAGE_LITTLEFS_BASE_PATH "/littlefs"
@@ -36,14 +41,87 @@
 // Directory permissions
 #define STORAGE_DIR_PERMISSIONS 0755
 
+// Driver files (snapshots, journals, cursors) live at the filesystem root under this
+// prefix and are hidden from listings and walks; every *_FILE name below starts with it
+#define STORAGE_RESERVED_PREFIX ".storage_"
+
+// Directory listing cache
+#define STORAGE_DIR_CACHE_ENTRIES 4            // Directories kept by list_directory (0 disables)
+
+// Key fan-out (hashed two-level bucket directories for large flat key spaces)
+#define STORAGE_ENABLE_KEY_FANOUT false        // Default for new instances, see set_key_fanout()
+#define STORAGE_FANOUT_MARKER '@'              // First character of bucket directory names
+
+// Bulk tree operations
+#define STORAGE_TREE_BATCH_SIZE 16             // Entries read per pass before deleting them
+
+// Buffer sizes
+#define STORAGE_CHECKSUM_BUFFER_SIZE 256       // Chunk size when checksumming files
+
+// Garbage collection (maintenance() and the idle scheduler)
+#define STORAGE_GC_RESERVE_BYTES 16384         // Erased space maintenance() tries to keep ready for writes
+#define STORAGE_GC_STEP_BYTES 4096             // Collected per step; idle collection yields between steps
+#define STORAGE_ENABLE_IDLE_GC false           // Run maintenance() from a task once I/O goes quiet
+#define STORAGE_IDLE_GC_DELAY_MS 2000          // Quiet time after the last call before collecting
+#define STORAGE_IDLE_GC_POLL_MS 1000           // How often the idle task checks
+#define STORAGE_IDLE_GC_TASK_STACK_SIZE 3072
+#define STORAGE_IDLE_GC_TASK_PRIORITY 1        // Below anything that does real I/O
+
+// Evictable (cache-class) files
+#define STORAGE_EVICT_HEADROOM_BYTES 4096      // Free space kept beyond a write's growth before evicting stops
+#define STORAGE_EVICT_SNAPSHOT_FILE ".storage_evict"  // Evictable set written at unmount, removed at mount
+
+// Expiring files (storage_write_options_t::ttl_seconds)
+#define STORAGE_TTL_JOURNAL_FILE ".storage_ttl"  // Expiry times, appended on change and compacted at mount/unmount
+#define STORAGE_TTL_REAP_BATCH 8               // Expired files deleted per reaper pass
+#define STORAGE_TTL_MIN_CLOCK 1577836800       // time() before 2020-01-01 means the clock is not set yet
+
+// Parallel walk configuration
+#define STORAGE_PARALLEL_WALK_WORKERS 2        // Worker threads (spread across cores)
+#define STORAGE_PARALLEL_WALK_STACK_SIZE 4096  // Stack size per worker thread
+
+// Metadata index (answers exists()/file_size() from RAM, persisted across clean unmounts)
+#define STORAGE_ENABLE_METADATA_INDEX false
+#define STORAGE_INDEX_SNAPSHOT_FILE ".storage_index"  // Snapshot written at unmount, removed at mount
+#define STORAGE_INDEX_REBUILD_BATCH 32         // Entries indexed per step while rebuilding
+
+// Tiered storage (storage_tiering)
+#define STORAGE_TIER_PROMOTE_HITS 4            // Accesses per aging period that make a key hot
+#define STORAGE_TIER_DEMOTE_HITS 0             // Keys at or below this many accesses are demoted
+#define STORAGE_TIER_MAX_PROMOTE_SIZE 4096     // Larger files never move to a faster tier
+#define STORAGE_TIER_MIGRATE_BATCH 4           // Keys moved per migration pass
+#define STORAGE_TIER_MIGRATE_INTERVAL_MS 5000  // Background pass interval (also the aging period)
+#define STORAGE_TIER_TASK_STACK_SIZE 4096
+#define STORAGE_TIER_TASK_PRIORITY 2
+
+// RAM disk (ram_storage)
+#define STORAGE_RAM_DEFAULT_BUDGET 0           // Byte budget for file contents (0 = limited by heap only)
+
+// Mirrored storage (storage_mirror)
+#define STORAGE_MIRROR_TASK_STACK_SIZE 4096    // Task writing the second replica
+#define STORAGE_MIRROR_TASK_PRIORITY 5
+#define STORAGE_MIRROR_TASK_CORE 1             // Core for the second replica (tskNO_AFFINITY for any)
+
 // File versioning configuration
 #define STORAGE_ENABLE_VERSIONING true  // Disabled by default for now
 #define STORAGE_MAX_VERSION_HISTORY 5    // Keep last N versions of each file
 #define STORAGE_VERSION_METADATA_EXT ".meta"  // Extension for metadata files
 
+// Consistency checker (versioning artifacts left behind by a crash)
+#define STORAGE_ENABLE_FSCK true                // Check after mounts that did not follow a clean unmount
+#define STORAGE_FSCK_CURSOR_FILE ".storage_fsck"  // Progress cursor; present while a check may be needed
+#define STORAGE_FSCK_STEP_US 2000               // Time budget of one checker step
+#define STORAGE_FSCK_MAX_PASSES 4               // Passes one check may take before it gives up
+
 // Thread safety configuration
 #define STORAGE_ENABLE_MUTEX_PROTECTION true
 #define STORAGE_MUTEX_TIMEOUT_MS portMAX_DELAY
 
 // Logging configuration
-#define STORAGE_ENABLE_DEBUG_LOGGING true
\ No newline at end of file
+#define STORAGE_ENABLE_DEBUG_LOGGING true
+
+// Statistics configuration
+#define STORAGE_ENABLE_IO_STATS false  // Default stats policy, see storage_policies.h
+
+// Power-loss fault injection (host builds only, see storage_fault.h)
+#define STORAGE_ENABLE_FAULT_INJECTION false
@@ -7,35 +7,148 @@
 #include "esp_partition.h"
 #include "esp_spiffs.h"
 #include "esp_littlefs.h"
+#include "dir_walker.h"
+#include "parallel_walker.h"
+#include "dir_cache.h"
+#include "key_fanout.h"
+#include "storage_policies.h"
+#include "storage_fault.h"
+#if STORAGE_ENABLE_VERSIONING
+#include "file_versioning.h"
+#else
+class file_versioning;  // storage_esp_impl.h includes it for policy sets that version
+#endif
 #include <string>
 #include <vector>
 #include <memory>
+#include <map>
+#include <list>
+#include <queue>
+#include <ctime>
 #include <sys/stat.h>
 #include <dirent.h>
-
-#if STORAGE_ENABLE_MUTEX_PROTECTION
+#include <atomic>
+#include <type_traits>
 #include "freertos/FreeRTOS.h"
-#include "freertos/semphr.h"
-#endif
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
 
-#if STORAGE_ENABLE_VERSIONING
-#include "file_versioning.h"
+#if STORAGE_ENABLE_METADATA_INDEX
+#include "metadata_index.h"
 #endif
 
+/**
+ * @brief Opaque position within a paginated directory listing
+ * 
+ * Pages are returned in name order and the cursor remembers the last name
+ * handed out, so it stays valid while entries are added or removed between
+ * calls. A default-constructed cursor starts at the first page.
+ */
+class dir_cursor_t {
+    public:
+        bool at_end() const { return _at_end; }
+        void reset() { _last_name.clear(); _at_end = false; }
+
+    private:
+        template <class, class, class, class> friend class basic_storage_esp;
+        std::string _last_name;
+        bool _at_end = false;
+};
+
+/**
+ * @brief Mount duration broken down by phase, in microseconds
+ */
+struct storage_mount_timing_t {
+    int64_t queued_us = 0;    // begin() until the mount started (background mode)
+    int64_t register_us = 0;  // VFS registration, including the filesystem mount itself
+    int64_t info_us = 0;      // Filesystem info query (debug logging only)
+    int64_t total_us = 0;     // begin() until storage was ready
+    bool background = false;
+};
+
+/**
+ * @brief Counts reported by tree operations (remove_tree, erase_prefix, usage)
+ */
+struct storage_tree_stats_t {
+    uint32_t files = 0;          // Data files
+    uint32_t version_files = 0;  // Versioning artifacts (.meta, .vN)
+    uint32_t directories = 0;
+    uint64_t bytes = 0;          // Bytes of all files counted
+};
+
+/**
+ * @brief Per-write options for write_file()
+ */
+struct storage_write_options_t {
+    bool evictable = false;  // Cache data: may be deleted, least recently used first, when space runs short
+    uint32_t ttl_seconds = 0;  // Expire this long after the write (0 = never); fails while the clock is unset
+};
+
+/**
+ * @brief Per-instance settings, defaulting to the storage_config.h macros
+ * 
+ * Features that are compiled out (STORAGE_ENABLE_*) stay unavailable whatever
+ * is set here; these fields only tune what is built in.
+ */
+struct storage_esp_config {
+    // Mount
+    size_t max_files = STORAGE_MAX_FILES;
+    bool format_if_mount_fails = STORAGE_FORMAT_IF_MOUNT_FAILS;
+    bool background_mount = STORAGE_BACKGROUND_MOUNT;
+    uint32_t mount_task_stack_size = STORAGE_MOUNT_TASK_STACK_SIZE;
+    uint32_t mount_task_priority = STORAGE_MOUNT_TASK_PRIORITY;
+
+    // Caches and key layout
+    size_t dir_cache_entries = STORAGE_DIR_CACHE_ENTRIES;
+    bool key_fanout = STORAGE_ENABLE_KEY_FANOUT;
+    size_t index_rebuild_batch = STORAGE_INDEX_REBUILD_BATCH;
+
+    // Versioning policy (needs STORAGE_ENABLE_VERSIONING)
+    bool versioning = STORAGE_ENABLE_VERSIONING;
+    uint32_t max_version_history = STORAGE_MAX_VERSION_HISTORY;  // Clamped to the compiled maximum
+    bool fsck = STORAGE_ENABLE_FSCK;                  // Repair versioning artifacts after an unclean shutdown
+    uint32_t fsck_step_us = STORAGE_FSCK_STEP_US;
+
+    // Locking
+    TickType_t lock_timeout = STORAGE_MUTEX_TIMEOUT_MS;  // Calls fail if the lock is not free in time
+
+    // Buffers
+    size_t tree_batch_size = STORAGE_TREE_BATCH_SIZE;
+    size_t checksum_buffer_size = STORAGE_CHECKSUM_BUFFER_SIZE;
+
+    // Garbage collection
+    size_t gc_reserve_bytes = STORAGE_GC_RESERVE_BYTES;
+    bool idle_gc = STORAGE_ENABLE_IDLE_GC;              // Start the idle scheduler on mount
+    uint32_t idle_gc_delay_ms = STORAGE_IDLE_GC_DELAY_MS;
+    uint32_t idle_gc_poll_ms = STORAGE_IDLE_GC_POLL_MS;
+};
+
 /**
  * @brief ESP32 Storage Driver Implementation
  * 
  * Native ESP-IDF storage driver supporting both SPIFFS and LittleFS
- * with configurable options through storage_config.h
+ * with configurable options through storage_config.h and storage_esp_config.
+ * Locking, versioning, I/O statistics and debug logging are policies (see
+ * storage_policies.h) resolved at compile time, so a disabled policy costs
+ * nothing and instances in one binary can differ. Quotas, reservations,
+ * eviction and expiry are runtime features of every instantiation; unused,
+ * each costs an empty-container check on the paths it hooks. Most code uses
+ * the storage_esp alias below.
  */
-class storage_esp : public storage_interface 
+template <class LockPolicy = storage_default_lock,
+          class VersionPolicy = storage_default_versioning,
+          class StatsPolicy = storage_default_stats,
+          class LogPolicy = storage_default_log>
+class basic_storage_esp : public storage_interface 
 {   
     public:
         // Constructors
-        storage_esp();
-        storage_esp(storage_type_t type, const std::string& partition = STORAGE_DEFAULT_PARTITION_LABEL);
-        storage_esp(storage_type_t type, const std::string& partition, const std::string& mount_point);
-        ~storage_esp();
+        basic_storage_esp();
+        basic_storage_esp(storage_type_t type, const std::string& partition = STORAGE_DEFAULT_PARTITION_LABEL);
+        basic_storage_esp(storage_type_t type, const std::string& partition, const std::string& mount_point,
+                          const storage_esp_config& config = storage_esp_config());
+        explicit basic_storage_esp(const storage_esp_config& config);
+        ~basic_storage_esp();
 
         // ===== storage_interface implementation =====
         bool begin() override;
@@ -50,60 +163,442 @@ class storage_esp : public storage_interface
         bool unmount() override;
         bool format() override;
         bool list_all_files(std::vector<file_info_t>& files) override;
-        bool get_is_mounted() const override { return _is_mounted; }
+        /**
+         * @brief Whether storage is mounted
+         * 
+         * Blocks until a background mount started by begin_async() has
+         * finished, so a mount in progress reports its result rather than false.
+         */
+        bool get_is_mounted() const override;
+
+        // ===== Background mount =====
+        /**
+         * @brief Start mounting on a background task and return immediately
+         * 
+         * Every storage call made before the mount finishes blocks until it has.
+         * begin() does this automatically when STORAGE_BACKGROUND_MOUNT is set.
+         * 
+         * @return true if the mount was started (or storage was already mounted).
+         *         Whether it succeeded is reported by wait_until_mounted() or
+         *         get_is_mounted(). Without a background task the mount runs in
+         *         place and its result is returned directly.
+         */
+        bool begin_async(bool format_on_fail = STORAGE_FORMAT_IF_MOUNT_FAILS);
+
+        /**
+         * @brief Block until a background mount has finished
+         * @return true if storage is mounted
+         */
+        bool wait_until_mounted(TickType_t timeout = portMAX_DELAY);
+
+        const storage_mount_timing_t& get_mount_timing() const { return _mount_timing; }
 
         // ===== Advanced file operations =====
+        /**
+         * @brief Write a file with per-write options
+         * 
+         * An evictable file may be deleted to make room when a later write
+         * would not fit otherwise; files are evicted least recently read or
+         * written first. Rewriting a key without the option makes it
+         * permanent again.
+         */
+        bool write_file(const std::string& key, const void* data, size_t data_size,
+                        const storage_write_options_t& options);
         bool read_file_alloc(const std::string& key, uint8_t** data, size_t* size);
         bool rename_file(const std::string& old_key, const std::string& new_key);
 
+        /**
+         * @brief Overwrite part of a file in place
+         * 
+         * Only the pages covering [offset, offset + data_size) are reprogrammed.
+         * The file is created if missing and grows if the span runs past its end.
+         * With versioning, the previous version is archived as a patch holding
+         * just the overwritten bytes.
+         */
+        bool write_file_range(const std::string& key, size_t offset, const void* data, size_t data_size);
+        bool read_file_range(const std::string& key, size_t offset, void* data, size_t data_size);
+
         // ===== Directory operations =====
         bool create_directory(const std::string& path);
-        bool list_directory(const std::string& path, std::vector<file_info_t>& files);
+        /**
+         * @brief List the entries of one directory
+         * @param attributes storage_attr_t flags the caller needs; the type is
+         *                   taken from dirent where possible and size costs a
+         *                   stat() per file, so it is only filled in on request
+         */
+        bool list_directory(const std::string& path, std::vector<file_info_t>& files,
+                            uint32_t attributes = STORAGE_ATTR_TYPE);
+
+        /**
+         * @brief List one page of a directory, resuming from cursor
+         * @param path Directory to list
+         * @param cursor Position to resume from; advanced past the returned page
+         * @param max_entries Maximum entries returned (bounds memory per page)
+         * @param files Receives the page, sorted by name
+         * @param attributes storage_attr_t flags to fill in; only STORAGE_ATTR_SIZE
+         *                   costs a stat(), and only for the files on the page
+         */
+        bool list_directory_page(const std::string& path, dir_cursor_t& cursor, size_t max_entries,
+                                 std::vector<file_info_t>& files, uint32_t attributes = STORAGE_ATTR_TYPE);
+
+        // ===== Streaming enumeration =====
+        /**
+         * @brief Create a lazy walker over all files whose key starts with prefix
+         * 
+         * The walker can be advanced at any pace and dropped at any time.
+         */
+        dir_walker walk_files(const std::string& prefix = "") const;
+
+        /**
+         * @brief Create a lazy walker with explicit options (glob, predicate, ...)
+         * 
+         * Key fan-out is applied according to this instance's setting.
+         */
+        dir_walker walk(const walk_options_t& options) const;
+
+        /**
+         * @brief Visit every file whose key starts with prefix without building a list
+         * 
+         * The storage mutex is not held while the visitor runs, so the visitor
+         * may call back into this instance. Return false from the visitor to stop.
+         */
+        bool for_each_file(const file_visitor_t& visitor, const std::string& prefix = "");
+
+        /**
+         * @brief Visit every file whose key matches a storage_glob pattern
+         * 
+         * Matching happens during the walk; directories the pattern cannot
+         * match below are never opened.
+         */
+        bool for_each_match(const std::string& pattern, const file_visitor_t& visitor);
+        bool list_matching(const std::string& pattern, std::vector<file_info_t>& files);
+
+        /**
+         * @brief Visit matching files from several worker threads at once
+         * 
+         * Intended for bulk jobs (checksumming, export) where the serial walk is
+         * the bottleneck. The visitor runs concurrently and must be thread safe.
+         */
+        bool for_each_file_parallel(const file_visitor_t& visitor, const std::string& prefix = "",
+                                    size_t num_workers = STORAGE_PARALLEL_WALK_WORKERS);
+
+        // ===== Bulk operations =====
+        /**
+         * @brief Delete a directory and everything below it in one locked walk
+         * 
+         * Children are removed before their parents and versioning artifacts go
+         * with the files they belong to, without per-file versioning cleanup.
+         * Removing the root ("" or "/") empties the filesystem but keeps the mount point.
+         * @param stats Optional; receives what was removed and the bytes freed
+         */
+        bool remove_tree(const std::string& path, storage_tree_stats_t* stats = nullptr);
+
+        /**
+         * @brief Delete every file whose key starts with prefix, in one locked walk
+         * 
+         * Metadata and all version archives of the matching files are removed in
+         * the same pass. Directories are left in place.
+         * @param stats Optional; receives what was removed and the bytes freed
+         */
+        bool erase_prefix(const std::string& prefix, storage_tree_stats_t* stats = nullptr);
+
+        /**
+         * @brief Disk usage below a directory, in one locked walk
+         */
+        bool usage(const std::string& path, storage_tree_stats_t& stats);
+
+        // ===== Key mapping =====
+        /**
+         * @brief Store files under hashed two-level bucket directories
+         * 
+         * Keys keep their logical names in every API. Must be chosen before
+         * any files are written: keys stored under the other layout are not found.
+         * Takes the lock, so it cannot switch layouts under a call in progress.
+         * @return false if the lock timed out
+         */
+        bool set_key_fanout(bool enable);
+        bool get_key_fanout() const { return _key_fanout; }
+
+        // ===== Space reservations =====
+        /**
+         * @brief Set space aside so a file can grow to bytes in later writes
+         * 
+         * Neither filesystem can allocate blocks without writing them, so the
+         * reservation is enforced by accounting. While any reservation is
+         * open, a write that grows a file past its own reservation is rejected
+         * if it would eat into space reserved for other files. used_size()
+         * counts the reserved but unwritten bytes as used.
+         * @param bytes Total size the file may reach; calling again resizes the reservation
+         */
+        bool reserve(const std::string& key, size_t bytes);
+
+        /**
+         * @brief Close a reservation, optionally shrinking the file to what was kept
+         * @param final_size Size to truncate the file to, SIZE_MAX to leave it as is
+         */
+        bool release(const std::string& key, size_t final_size = SIZE_MAX);
+
+        /**
+         * @brief Shrink a file to size bytes; never grows it
+         * 
+         * Uses truncate() where the VFS supports it, otherwise rewrites the kept
+         * prefix through a temporary file. With versioning, the cut tail is
+         * archived as a patch.
+         */
+        bool truncate_file(const std::string& key, size_t size);
+
+        size_t get_reserved_bytes();
+
+        // ===== Quotas =====
+        /**
+         * @brief Cap the bytes stored under a key prefix, e.g. "logs/"
+         * 
+         * Usage is counted once when the quota is set (or at mount) and then
+         * kept up to date by every write, erase, rename and tree operation, so
+         * write_file() and write_file_range() can reject a write that would go
+         * over without walking the directory. Version archives count towards
+         * the quota of their file but are never rejected themselves. Nested
+         * prefixes are each enforced. Quotas are held in RAM.
+         * @param limit_bytes Bytes allowed under prefix; setting again changes the limit
+         */
+        bool set_quota(const std::string& prefix, size_t limit_bytes);
+        bool remove_quota(const std::string& prefix);
+
+        /**
+         * @brief Current usage and limit of a quota
+         * @return false if no quota is set for prefix
+         */
+        bool get_quota(const std::string& prefix, uint64_t& used, size_t& limit);
+
+        // ===== Evictable files =====
+        bool is_evictable(const std::string& key);
+        size_t get_evictable_count();
+        uint32_t get_evictions() const { return _evictions; }
+
+        // ===== Expiring files =====
+        /**
+         * @brief Delete up to max_files files whose TTL has passed
+         * 
+         * Expired files already read as missing; this reclaims their space.
+         * Writes run a pass on their own whenever the earliest expiry is due,
+         * so calling this is only needed to free space sooner.
+         * @return Number of files deleted
+         */
+        size_t reap_expired(size_t max_files = STORAGE_TTL_REAP_BATCH);
+
+        /**
+         * @brief Expiry time of a file as time() seconds, 0 if it never expires
+         */
+        time_t get_expiry(const std::string& key);
+
+        // ===== Maintenance =====
+        /**
+         * @brief Reclaim deleted pages ahead of time so later writes need not
+         *
+         * SPIFFS erases blocks holding deleted pages on demand, inside whichever
+         * write runs out of free pages; this does that work now instead.
+         * LittleFS erases lazily per block and has nothing to collect, so it
+         * returns true at once.
+         * @param reserve_bytes Erased space to make available, capped at the free space
+         * @return true if the reserve is available
+         */
+        bool maintenance(size_t reserve_bytes);
+        bool maintenance() { return maintenance(_config.gc_reserve_bytes); }
+
+        /**
+         * @brief Run maintenance() from a low-priority task whenever storage is idle
+         *
+         * Idle means no call for idle_gc_delay_ms and the lock free. Collection
+         * only runs after files were written or removed. Started by mount()
+         * when the config sets idle_gc; stopped by unmount(). The same task
+         * runs a pending consistency check, and mount() starts it for that
+         * alone when idle_gc is off.
+         */
+        bool start_idle_gc();
+        void stop_idle_gc();
+        uint32_t get_gc_runs() const { return _gc_runs; }
+
+        // ===== Consistency checker =====
+        /**
+         * @brief Check and repair versioning artifacts for about budget_us
+         *
+         * A check is pending after a mount that did not follow a clean
+         * unmount. One walk is kept open across steps, and the last artifact
+         * checked is persisted after every step, so an interrupted check
+         * resumes where it stopped on the next boot. The idle task takes steps on its own;
+         * idle code can call this to finish sooner.
+         * @return true once no check is pending
+         */
+        bool check_step(uint32_t budget_us);
+        bool check_step() { return check_step(_config.fsck_step_us); }
+        bool is_check_pending() const { return _fsck_pending; }
+        uint32_t get_check_repairs() const { return _fsck_repairs; }
 
         // ===== Utility functions =====
         bool verify_file_integrity(const std::string& key, size_t expected_size, uint32_t* checksum = nullptr);
 
         // ===== Getters =====
+        const storage_esp_config& get_config() const { return _config; }
+        const StatsPolicy& get_stats() const { return _stats; }
+        StatsPolicy& get_stats() { return _stats; }
+        const dir_cache& get_dir_cache() const { return _dir_cache; }
         storage_type_t get_storage_type() const { return _storage_type; }
         std::string get_base_path() const { return _base_path; }
         std::string get_partition_label() const { return _partition_label; }
 
-    #if STORAGE_ENABLE_VERSIONING
+    #if STORAGE_ENABLE_METADATA_INDEX
+        // ===== Metadata index =====
+        /**
+         * @brief Advance a pending index rebuild by up to max_entries
+         * 
+         * The index is loaded from the snapshot left by the last clean unmount.
+         * When that is missing or corrupt it is rebuilt by walking the
+         * filesystem in small steps: every exists()/file_size() call takes one,
+         * and idle code can call this to finish sooner.
+         * @return true once the index is complete
+         */
+        bool rebuild_index_step(size_t max_entries = STORAGE_INDEX_REBUILD_BATCH);
+        const metadata_index& get_metadata_index() const { return _index; }
+    #endif
+
         // ===== Versioning access =====
+        /**
+         * @brief Versioning manager, or nullptr when VersionPolicy disables it
+         */
         file_versioning* get_versioning() { 
-            _init_versioning();
-            return _versioning.get(); 
+            if constexpr (VersionPolicy::enabled) {
+                _init_versioning();
+                return _versioning.get(); 
+            } else {
+                return nullptr;
+            }
         }
         const file_versioning* get_versioning() const { 
-            return _versioning.get(); 
+            if constexpr (VersionPolicy::enabled) {
+                return _versioning.get(); 
+            } else {
+                return nullptr;
+            }
         }
-    #endif
 
     private:
+        storage_esp_config _config;
         storage_type_t _storage_type;
         std::string _base_path;
         std::string _partition_label;
-        bool _is_mounted;
+        std::atomic<bool> _is_mounted;  // read by the mount task and callers without the lock
+        bool _key_fanout;
+        dir_cache _dir_cache;
+        LockPolicy _lock;
+        StatsPolicy _stats;
 
-    #if STORAGE_ENABLE_VERSIONING
-        std::unique_ptr<file_versioning> _versioning;
-        void _init_versioning();
-    #endif
+        using lock_guard = typename LockPolicy::guard;
+        static constexpr const char* TAG = "storage_esp";
 
-    #if STORAGE_ENABLE_MUTEX_PROTECTION
-        SemaphoreHandle_t _storage_mutex;
+        // Background mount state
+        EventGroupHandle_t _mount_events;
+        std::atomic<bool> _mount_pending;  // Set by begin_async(), cleared by the first call that sees it done
+        bool _mount_format_on_fail;
+        int64_t _mount_requested_us;
+        storage_mount_timing_t _mount_timing;
+        static constexpr EventBits_t MOUNT_DONE_BIT = (1 << 0);
+        static void _mount_task(void* arg);
+        bool _mount_running() const;
+        void _await_mount();
 
-        class mutex_guard {
-        public:
-            explicit mutex_guard(SemaphoreHandle_t& mutex) : m_mutex(mutex) {
-                xSemaphoreTake(m_mutex, STORAGE_MUTEX_TIMEOUT_MS);
-            }
-            ~mutex_guard() {
-                xSemaphoreGive(m_mutex);
-            }
-        private:
-            SemaphoreHandle_t& m_mutex;
+        // Idle garbage collection state
+        std::atomic<int64_t> _last_call_us;  // Start of the most recent public call
+        std::atomic<bool> _gc_needed;        // Files written or removed since the last collection
+        std::atomic<uint32_t> _gc_runs;        // Collections that ran, explicit or idle
+        std::atomic<bool> _idle_collect;     // Collect garbage, not only run a pending check
+        bool _gc_task_running;
+        std::atomic<bool> _gc_task_stop;
+        static constexpr EventBits_t GC_EXITED_BIT = (1 << 1);
+        static void _idle_gc_task(void* arg);
+        bool _start_idle_task();
+        bool _maintenance_locked(size_t reserve_bytes, bool yield_to_callers);
+
+        // Consistency checker; _fsck_cursor is the artifact the walk last
+        // returned, checked unless _fsck_held
+        std::atomic<bool> _fsck_pending;
+        std::string _fsck_cursor;
+        std::unique_ptr<dir_walker> _fsck_walk;  // Open while a pass is in progress
+        bool _fsck_skipping;  // A restarted walk is skipping up to _fsck_cursor
+        bool _fsck_rescan;    // The pass in progress needs another one after it
+        bool _fsck_held;      // The step ran out of time before checking _fsck_cursor
+        uint32_t _fsck_passes;
+        std::atomic<uint32_t> _fsck_repairs;
+        bool _fsck_enabled() const { return _versioning_enabled() && _config.fsck; }
+        void _fsck_load();
+        void _fsck_save();
+        bool _fsck_step_locked(uint32_t budget_us);
+
+        // Open reservations by key; size tracks the file so only the unwritten part counts
+        struct reservation {
+            size_t reserved;
+            size_t size;
         };
+        std::map<std::string, reservation> _reservations;
+        size_t _outstanding_reservations(const std::string& except) const;
+        bool _admit_growth(const std::string& key, size_t old_size, size_t new_size);
+        bool _truncate_locked(const std::string& key, size_t size);
+        void _reservation_rename(const std::string& old_key, const std::string& new_key);
+
+        // Quotas by normalized prefix
+        struct quota {
+            size_t limit;
+            uint64_t used;
+        };
+        std::map<std::string, quota> _quotas;
+        static bool _quota_matches(const std::string& prefix, const std::string& relative_key) {
+            return relative_key.compare(0, prefix.length(), prefix) == 0;
+        }
+        bool _quota_tracks(const std::string& key) const;
+        bool _quota_admit(const std::string& key, size_t old_size, size_t new_size) const;
+        void _quota_adjust(const std::string& key, size_t old_size, size_t new_size);
+        void _quota_note_tree_removed(const std::string& dir_key, uint64_t bytes);
+        void _quota_recount(const std::string& prefix, quota& entry);
+
+        // Evictable keys, most recently used first, and where each sits in that list
+        std::list<std::string> _lru;
+        std::map<std::string, std::list<std::string>::iterator> _evictable;
+        std::atomic<uint32_t> _evictions;
+        void _evict_touch(const std::string& key, bool insert);
+        void _evict_forget_tree(const std::string& relative_key);
+        void _evict_rename(const std::string& old_key, const std::string& new_key);
+        void _evict_for(size_t bytes, const std::string& writing_key);
+        void _evict_load();
+        void _evict_save();
+
+        // Expiry time by key, and a min-heap over it that may hold stale entries
+        using expiry_entry = std::pair<uint32_t, std::string>;
+        std::map<std::string, uint32_t> _expiry;
+        std::priority_queue<expiry_entry, std::vector<expiry_entry>, std::greater<expiry_entry>> _expiry_heap;
+        size_t _ttl_journal_records;
+        static const uint32_t TTL_JOURNAL_MAGIC = 0x4a4c5454;  // "TTLJ"
+        bool _ttl_expired(const std::string& key) const;
+        void _ttl_set(const std::string& relative_key, uint32_t expires);
+        void _ttl_prune_heap();
+        void _ttl_forget_tree(const std::string& relative_key);
+        void _ttl_rename(const std::string& old_key, const std::string& new_key);
+        void _ttl_journal(const std::vector<expiry_entry>& records);
+        void _ttl_compact();
+        void _ttl_load();
+        size_t _reap_locked(size_t max_files);
+
+        // A bare pointer that stays null when VersionPolicy is off, so that
+        // instantiation never references file_versioning
+        std::conditional_t<VersionPolicy::enabled, std::unique_ptr<file_versioning>, file_versioning*> _versioning{};
+        void _init_versioning();
+        bool _versioning_enabled() const { return VersionPolicy::enabled && _config.versioning; }
+
+    #if STORAGE_ENABLE_METADATA_INDEX
+        metadata_index _index;
+        std::unique_ptr<dir_walker> _index_rebuild;  // Set while a rebuild is in progress
+        void _index_load();
+        void _index_save();
+        void _index_start_rebuild();
+        bool _index_rebuild_locked(size_t max_entries);
     #endif
 
         // ===== Internal helpers =====
@@ -111,7 +606,21 @@ class storage_esp : public storage_interface
             return _storage_type == STORAGE_TYPE_SPIFFS ? "SPIFFS" : "LittleFS";
         }
         std::string _get_full_path(const std::string& relative_path) const;
+        std::string _get_file_path(const std::string& key) const;
         bool _create_directory_recursive(const std::string& path);
+        bool _remove_tree_locked(const std::string& full_path, storage_tree_stats_t& stats);
+        static bool _is_version_artifact(const std::string& name);
+        std::string _get_relative_dir(const std::string& path) const;
+        bool _is_reserved_key(const std::string& key) const;
+        void _split_key(const std::string& key, std::string& dir, std::string& name) const;
+        walk_options_t _walk_options(const std::string& prefix) const;
+        bool _read_entry_attributes(const std::string& key, uint32_t attributes, file_info_t& info) const;
+        bool _stat_key(const std::string& key, size_t* size);
+        bool _fs_info(size_t& total, size_t& used) const;
+        bool _erase_file_locked(const std::string& key);
+        void _cache_note_written(const std::string& key, size_t size);
+        void _cache_note_directory(const std::string& full_path);
+        void _cache_note_removed(const std::string& key);
         void _init_default_config();
 
         // Internal raw file operations (used by versioning callbacks)
@@ -119,4 +628,26 @@ class storage_esp : public storage_interface
         bool _write_file_internal(const std::string& key, const void* data, size_t data_size);
         bool _write_file_no_mutex(const std::string& key, const void* data, size_t data_size);
         bool _read_file_no_mutex(const std::string& key, void* data, size_t data_size);
-};
\ No newline at end of file
+        bool _read_file_range_no_mutex(const std::string& key, size_t offset, void* data, size_t data_size);
+};
+
+/**
+ * @brief Storage driver with the features selected in storage_config.h
+ */
+using storage_esp = basic_storage_esp<>;
+
+/**
+ * @brief Storage driver with every policy compiled out
+ * 
+ * No locking, versioning (so no consistency check either), statistics or
+ * debug logging - for instances owned by a single task where the calls
+ * should cost little more than stdio itself. The runtime features stay
+ * available and cost nothing beyond a check while unused.
+ */
+using storage_esp_minimal = basic_storage_esp<storage_null_lock, storage_versioning_off,
+                                              storage_null_stats, storage_quiet_log>;
+
+// Instantiated once in storage_esp.cpp; include storage_esp_impl.h for other policy sets
+extern template class basic_storage_esp<>;
+extern template class basic_storage_esp<storage_null_lock, storage_versioning_off,
+                                         storage_null_stats, storage_quiet_log>;
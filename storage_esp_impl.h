@@ -0,0 +1,3269 @@
+#pragma once
+
+// Member definitions of basic_storage_esp. Only needed by translation units
+// instantiating policy combinations other than the two storage_esp.cpp provides.
+
+#include "storage_esp.h"
+#include "file_versioning.h"
+#include "esp_timer.h"
+#include <unistd.h>
+#include <errno.h>
+#include <cstring>
+#include <algorithm>
+
+#define STORAGE_ESP_TEMPLATE template <class LockPolicy, class VersionPolicy, class StatsPolicy, class LogPolicy>
+#define STORAGE_ESP_CLASS basic_storage_esp<LockPolicy, VersionPolicy, StatsPolicy, LogPolicy>
+
+// ========== Constructors and Destructor ==========
+
+STORAGE_ESP_TEMPLATE
+STORAGE_ESP_CLASS::basic_storage_esp() : basic_storage_esp(STORAGE_DEFAULT_TYPE, STORAGE_DEFAULT_PARTITION_LABEL, STORAGE_DEFAULT_BASE_PATH) {
+}
+
+STORAGE_ESP_TEMPLATE
+STORAGE_ESP_CLASS::basic_storage_esp(storage_type_t type, const std::string& partition)
+    : basic_storage_esp(type, partition,
+                        type == STORAGE_TYPE_SPIFFS ? STORAGE_SPIFFS_BASE_PATH : STORAGE_LITTLEFS_BASE_PATH) {
+}
+
+STORAGE_ESP_TEMPLATE
+STORAGE_ESP_CLASS::basic_storage_esp(const storage_esp_config& config)
+    : basic_storage_esp(STORAGE_DEFAULT_TYPE, STORAGE_DEFAULT_PARTITION_LABEL, STORAGE_DEFAULT_BASE_PATH, config) {
+}
+
+STORAGE_ESP_TEMPLATE
+STORAGE_ESP_CLASS::basic_storage_esp(storage_type_t type, const std::string& partition,
+                                     const std::string& mount_point, const storage_esp_config& config)
+    : _config(config), _storage_type(type), _base_path(mount_point), _partition_label(partition), _is_mounted(false),
+      _key_fanout(config.key_fanout), _dir_cache(config.dir_cache_entries),
+      _mount_events(nullptr), _mount_pending(false), _mount_format_on_fail(config.format_if_mount_fails),
+      _mount_requested_us(0), _last_call_us(0), _gc_needed(false), _gc_runs(0),
+      _idle_collect(false), _gc_task_running(false), _gc_task_stop(false),
+      _fsck_pending(false), _fsck_skipping(false), _fsck_rescan(false),
+      _fsck_held(false), _fsck_passes(0), _fsck_repairs(0), _evictions(0), _ttl_journal_records(0) {
+    
+    _init_default_config();
+}
+
+STORAGE_ESP_TEMPLATE
+STORAGE_ESP_CLASS::~basic_storage_esp() {
+    // Never tear down underneath a mount still in progress. The bit, not
+    // _mount_pending, is the mount task's last use of this instance
+    if (_mount_events != nullptr) {
+        xEventGroupWaitBits(_mount_events, MOUNT_DONE_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+    
+    stop_idle_gc();
+    if (_is_mounted) {
+        unmount();
+    }
+    
+    if (_mount_events != nullptr) {
+        vEventGroupDelete(_mount_events);
+    }
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_init_default_config() {
+    if (_config.max_version_history > STORAGE_MAX_VERSION_HISTORY) {
+        ESP_LOGW(TAG, "max_version_history %u exceeds compiled maximum, using %u",
+                 (unsigned)_config.max_version_history, (unsigned)STORAGE_MAX_VERSION_HISTORY);
+        _config.max_version_history = STORAGE_MAX_VERSION_HISTORY;
+    }
+    if (_config.tree_batch_size == 0) {
+        _config.tree_batch_size = 1;
+    }
+    if (_config.checksum_buffer_size == 0) {
+        _config.checksum_buffer_size = STORAGE_CHECKSUM_BUFFER_SIZE;
+    }
+    if (_config.idle_gc_poll_ms == 0) {
+        _config.idle_gc_poll_ms = STORAGE_IDLE_GC_POLL_MS;
+    }
+
+    _mount_events = xEventGroupCreate();
+    if (_mount_events == nullptr) {
+        ESP_LOGE(TAG, "Failed to create mount event group");
+    } else {
+        // No background mount is running until begin_async() clears it
+        xEventGroupSetBits(_mount_events, MOUNT_DONE_BIT);
+    }
+
+    if constexpr (LogPolicy::debug) {
+        ESP_LOGI(TAG, "Storage initialized: type=%s, partition=%s, base_path=%s",
+                 _get_storage_type_name(), _partition_label.c_str(), _base_path.c_str());
+    }
+}
+
+// ========== Versioning Initialization ==========
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_init_versioning() {
+    // Nothing to set up, and no file_versioning code, when the policy is off
+    if constexpr (VersionPolicy::enabled) {
+        if (_versioning) {
+            return; // Already initialized
+        }
+        
+        // Create versioning with callback interface
+        file_versioning::storage_callbacks callbacks;
+        
+        callbacks.get_full_path = [this](const std::string& key) -> std::string {
+            return this->_get_file_path(key);
+        };
+        
+        callbacks.read_file = [this](const std::string& key, void* data, size_t size) -> bool {
+            return this->_read_file_no_mutex(key, data, size);
+        };
+        
+        callbacks.read_file_range = [this](const std::string& key, size_t offset, void* data, size_t size) -> bool {
+            return this->_read_file_range_no_mutex(key, offset, data, size);
+        };
+        
+        callbacks.write_file = [this](const std::string& key, const void* data, size_t size) -> bool {
+            return this->_write_file_no_mutex(key, data, size);
+        };
+        
+        callbacks.delete_file = [this](const std::string& key) -> bool {
+            std::string full_path = this->_get_file_path(key);
+            size_t old_size = 0;
+            if (this->_quota_tracks(key)) {
+                this->_stat_key(key, &old_size);
+            }
+            if (STORAGE_FAULT_POINT("erase") || unlink(full_path.c_str()) != 0) {
+                return false;
+            }
+            this->_cache_note_removed(key);
+            this->_quota_adjust(key, old_size, 0);
+            return true;
+        };
+        
+        callbacks.get_file_size = [this](const std::string& key) -> size_t {
+            size_t size = 0;
+            this->_stat_key(key, &size);
+            return size;
+        };
+        
+        callbacks.file_exists = [this](const std::string& key) -> bool {
+            return this->_stat_key(key, nullptr);
+        };
+        
+        callbacks.is_mounted = [this]() -> bool {
+            return this->_is_mounted;
+        };
+        
+        _versioning = std::make_unique<file_versioning>(callbacks);
+        _versioning->set_max_history(_config.max_version_history);
+        
+        if constexpr (LogPolicy::debug) {
+            ESP_LOGI(TAG, "File versioning initialized");
+        }
+    }
+}
+
+// ========== Helper Methods ==========
+
+STORAGE_ESP_TEMPLATE
+std::string STORAGE_ESP_CLASS::_get_full_path(const std::string& relative_path) const {
+    if (relative_path.empty()) {
+        return _base_path;
+    }
+    if (relative_path[0] != '/') {
+        return _base_path + "/" + relative_path;
+    }
+    return _base_path + relative_path;
+}
+
+STORAGE_ESP_TEMPLATE
+std::string STORAGE_ESP_CLASS::_get_relative_dir(const std::string& path) const {
+    size_t start = path.find_first_not_of('/');
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = path.find_last_not_of('/');
+    return path.substr(start, end - start + 1);
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::_is_reserved_key(const std::string& key) const {
+    // Listings and walks skip reserved root names, so anything below one would vanish too
+    std::string relative = _get_relative_dir(key);
+    if (!dir_walker::is_reserved("", relative.substr(0, relative.find('/')).c_str())) {
+        return false;
+    }
+    ESP_LOGE(TAG, "Keys starting %s are reserved: %s", STORAGE_RESERVED_PREFIX, key.c_str());
+    return true;
+}
+
+STORAGE_ESP_TEMPLATE
+std::string STORAGE_ESP_CLASS::_get_file_path(const std::string& key) const {
+    if (!_key_fanout) {
+        return _get_full_path(key);
+    }
+    return _get_full_path(key_fanout::map_key(_get_relative_dir(key)));
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_split_key(const std::string& key, std::string& dir, std::string& name) const {
+    std::string relative = _get_relative_dir(key);
+    size_t last_slash = relative.rfind('/');
+    if (last_slash == std::string::npos) {
+        dir.clear();
+        name = relative;
+    } else {
+        dir = _get_relative_dir(relative.substr(0, last_slash));
+        name = relative.substr(last_slash + 1);
+    }
+}
+
+STORAGE_ESP_TEMPLATE
+walk_options_t STORAGE_ESP_CLASS::_walk_options(const std::string& prefix) const {
+    walk_options_t options;
+    options.prefix = prefix;
+    options.fanout = _key_fanout;
+    return options;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::_read_entry_attributes(const std::string& key, uint32_t attributes, file_info_t& info) const {
+    // Under fan-out only files are relocated, so try the file layout first
+    if (_key_fanout && attributes != STORAGE_ATTR_NAME &&
+        dir_walker::read_attributes(_get_file_path(key), NULL, attributes, info)) {
+        return true;
+    }
+    return dir_walker::read_attributes(_get_full_path(key), NULL, attributes, info);
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::_stat_key(const std::string& key, size_t* size) {
+#if STORAGE_ENABLE_METADATA_INDEX
+    std::string index_key = _get_relative_dir(key);
+    if (!index_key.empty() && _index_rebuild_locked(_config.index_rebuild_batch)) {
+        metadata_index::entry info;
+        if (!_index.lookup(index_key, info)) {
+            return false;
+        }
+        if (size) {
+            *size = info.size;
+        }
+        return true;
+    }
+#endif
+
+    struct stat st;
+    if (stat(_get_file_path(key).c_str(), &st) != 0) {
+        return false;
+    }
+    if (size) {
+        *size = st.st_size;
+    }
+    return true;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::_fs_info(size_t& total, size_t& used) const {
+    total = 0;
+    used = 0;
+    esp_err_t ret = ESP_FAIL;
+    
+    if (_storage_type == STORAGE_TYPE_SPIFFS) {
+#ifdef STORAGE_SPIFFS_AVAILABLE
+        ret = esp_spiffs_info(_partition_label.c_str(), &total, &used);
+#endif
+    } else {
+#ifdef STORAGE_LITTLEFS_AVAILABLE
+        ret = esp_littlefs_info(_partition_label.c_str(), &total, &used);
+#endif
+    }
+    
+    return ret == ESP_OK;
+}
+
+// ========== Cache Maintenance ==========
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_cache_note_written(const std::string& key, size_t size) {
+    // Rewriting a file leaves its old pages deleted, for the next collection
+    _gc_needed = true;
+    if (!_reservations.empty()) {
+        auto it = _reservations.find(_get_relative_dir(key));
+        if (it != _reservations.end()) {
+            it->second.size = size;
+        }
+    }
+#if STORAGE_ENABLE_METADATA_INDEX
+    _index.put(_get_relative_dir(key), size, false);
+#endif
+    if (!_dir_cache.enabled()) {
+        return;
+    }
+    std::string dir, name;
+    _split_key(key, dir, name);
+    _dir_cache.note_file_written(dir, name, size);
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_cache_note_directory(const std::string& full_path) {
+    std::string dir, name;
+    _split_key(full_path.substr(_base_path.length()), dir, name);
+    // Bucket directories never show up in listings
+    if (_key_fanout && key_fanout::is_bucket(name.c_str())) {
+        return;
+    }
+#if STORAGE_ENABLE_METADATA_INDEX
+    _index.put(dir.empty() ? name : dir + "/" + name, 0, true);
+#endif
+    if (_dir_cache.enabled()) {
+        _dir_cache.note_directory_created(dir, name);
+    }
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_cache_note_removed(const std::string& key) {
+    _gc_needed = true;
+    if (!_reservations.empty()) {
+        auto it = _reservations.find(_get_relative_dir(key));
+        if (it != _reservations.end()) {
+            it->second.size = 0;
+        }
+    }
+    if (!_evictable.empty()) {
+        _evict_forget_tree(_get_relative_dir(key));
+    }
+    if (!_expiry.empty()) {
+        _ttl_forget_tree(_get_relative_dir(key));
+    }
+#if STORAGE_ENABLE_METADATA_INDEX
+    _index.erase_tree(_get_relative_dir(key));
+#endif
+    if (!_dir_cache.enabled()) {
+        return;
+    }
+    std::string dir, name;
+    _split_key(key, dir, name);
+    _dir_cache.note_removed(dir, name);
+    // A removed directory takes its cached subtree with it
+    _dir_cache.invalidate_tree(dir.empty() ? name : dir + "/" + name);
+}
+
+// ========== Metadata Index ==========
+
+#if STORAGE_ENABLE_METADATA_INDEX
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_index_load() {
+    std::string snapshot_path = _get_full_path(STORAGE_INDEX_SNAPSHOT_FILE);
+    bool loaded = _index.load(snapshot_path);
+    
+    // The snapshot only describes the filesystem as it was at unmount. Removing
+    // it now means a crash before the next clean unmount forces a rebuild
+    // instead of loading a stale index.
+    unlink(snapshot_path.c_str());
+    
+    if (loaded) {
+        if constexpr (LogPolicy::debug) {
+            ESP_LOGI(TAG, "Loaded metadata index snapshot: %u entries", (unsigned)_index.size());
+        }
+    } else {
+        _index_start_rebuild();
+    }
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_index_save() {
+    // An incomplete index is not worth saving - the next mount rebuilds anyway
+    _index_rebuild.reset();
+    if (_index.is_valid()) {
+        if (!STORAGE_FAULT_POINT("index.snapshot")) {
+            _index.save(_get_full_path(STORAGE_INDEX_SNAPSHOT_FILE));
+        }
+    }
+    _index.clear();
+    _index.set_valid(false);
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_index_start_rebuild() {
+    if constexpr (LogPolicy::debug) {
+        ESP_LOGI(TAG, "Metadata index snapshot missing or stale, rebuilding");
+    }
+    _index.clear();
+    _index.set_valid(false);
+    
+    walk_options_t options = _walk_options("");
+    options.include_directories = true;
+    _index_rebuild.reset(new dir_walker(_base_path, options));
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::_index_rebuild_locked(size_t max_entries) {
+    if (!_index_rebuild) {
+        return _index.is_valid();
+    }
+    
+    // Mutations made since the rebuild started are already in the index, and
+    // the walk sees the filesystem as of each step, so the two agree
+    file_info_t info;
+    for (size_t i = 0; i < max_entries; i++) {
+        if (!_index_rebuild->next(info)) {
+            _index_rebuild.reset();
+            _index.set_valid(true);
+            if constexpr (LogPolicy::debug) {
+                ESP_LOGI(TAG, "Metadata index rebuilt: %u entries", (unsigned)_index.size());
+            }
+            return true;
+        }
+        _index.put(info.path, info.size, info.is_directory);
+    }
+    
+    return false;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::rebuild_index_step(size_t max_entries) {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    if (!_is_mounted) {
+        return false;
+    }
+    
+    return _index_rebuild_locked(max_entries);
+}
+#endif
+
+// ========== Public Interface Methods ==========
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::begin() {
+    if (_config.background_mount) {
+        return begin_async(_config.format_if_mount_fails);
+    }
+    _mount_requested_us = esp_timer_get_time();
+    return mount(_config.format_if_mount_fails);
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::mount(bool format_on_fail) {
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    if (_is_mounted) {
+        ESP_LOGW(TAG, "Storage already mounted");
+        return true;
+    }
+    
+    int64_t start_us = esp_timer_get_time();
+    if (_mount_requested_us == 0) {
+        _mount_requested_us = start_us;
+    }
+    _mount_timing.queued_us = start_us - _mount_requested_us;
+    _mount_timing.info_us = 0;
+    _mount_timing.background = _mount_running();
+    
+    esp_err_t ret = ESP_FAIL;
+    
+    if (_storage_type == STORAGE_TYPE_SPIFFS) {
+#ifdef STORAGE_SPIFFS_AVAILABLE
+        esp_vfs_spiffs_conf_t conf = {
+            .base_path = _base_path.c_str(),
+            .partition_label = _partition_label.c_str(),
+            .max_files = _config.max_files,
+            .format_if_mount_failed = format_on_fail
+        };
+        
+        ret = esp_vfs_spiffs_register(&conf);
+        _mount_timing.register_us = esp_timer_get_time() - start_us;
+        if (ret == ESP_OK) {
+            if constexpr (LogPolicy::debug) {
+                ESP_LOGI(TAG, "SPIFFS mounted successfully on %s", _base_path.c_str());
+            }
+            _is_mounted = true;
+        } else {
+            ESP_LOGE(TAG, "Failed to mount SPIFFS: %s", esp_err_to_name(ret));
+            if (!format_on_fail) {
+                ESP_LOGW(TAG, "Try mounting with format_on_fail=true if needed");
+            }
+        }
+#else
+        ESP_LOGE(TAG, "SPIFFS not available - check storage_config.h");
+        return false;
+#endif
+    } else {
+#ifdef STORAGE_LITTLEFS_AVAILABLE
+        esp_vfs_littlefs_conf_t conf = {
+            .base_path = _base_path.c_str(),
+            .partition_label = _partition_label.c_str(),
+            .format_if_mount_failed = format_on_fail,
+            .dont_mount = false
+        };
+        
+        ret = esp_vfs_littlefs_register(&conf);
+        _mount_timing.register_us = esp_timer_get_time() - start_us;
+        if (ret == ESP_OK) {
+            if constexpr (LogPolicy::debug) {
+                ESP_LOGI(TAG, "LittleFS mounted successfully on %s", _base_path.c_str());
+            }
+            _is_mounted = true;
+            
+            if constexpr (LogPolicy::debug) {
+                // Log filesystem info after successful mount - only worth its cost when logged
+                int64_t info_start_us = esp_timer_get_time();
+                size_t total = 0, used = 0;
+                esp_littlefs_info(_partition_label.c_str(), &total, &used);
+                _mount_timing.info_us = esp_timer_get_time() - info_start_us;
+                ESP_LOGI(TAG, "LittleFS info - Total: %zu bytes, Used: %zu bytes", total, used);
+            }
+        } else {
+            ESP_LOGE(TAG, "Failed to mount LittleFS: %s", esp_err_to_name(ret));
+            if (!format_on_fail) {
+                ESP_LOGW(TAG, "Try mounting with format_on_fail=true if needed");
+            }
+        }
+#else
+        ESP_LOGE(TAG, "LittleFS not available - check storage_config.h");
+        return false;
+#endif
+    }
+    
+    // Versioning is set up on first use rather than on the boot path
+    
+#if STORAGE_ENABLE_METADATA_INDEX
+    if (ret == ESP_OK) {
+        _index_load();
+    }
+#endif
+    
+    if (ret == ESP_OK) {
+        _evict_load();
+        _ttl_load();
+        _fsck_load();
+    }
+    
+    _mount_timing.total_us = esp_timer_get_time() - _mount_requested_us;
+    _mount_requested_us = 0;
+    
+    if (ret == ESP_OK) {
+        for (auto& entry : _quotas) {
+            _quota_recount(entry.first, entry.second);
+        }
+    }
+    
+    if (ret == ESP_OK && _config.idle_gc) {
+        start_idle_gc();
+    } else if (ret == ESP_OK && _fsck_pending) {
+        // The check runs in the background rather than on the boot path
+        if constexpr (!std::is_same_v<LockPolicy, storage_null_lock>) {
+            _start_idle_task();
+        }
+    }
+    
+    if constexpr (LogPolicy::debug) {
+        ESP_LOGI(TAG, "Mount took %lld us (queued %lld, register %lld, info %lld)%s",
+                 (long long)_mount_timing.total_us, (long long)_mount_timing.queued_us,
+                 (long long)_mount_timing.register_us, (long long)_mount_timing.info_us,
+                 _mount_timing.background ? " in background" : "");
+    }
+    
+    return ret == ESP_OK;
+}
+
+// ========== Background Mount ==========
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::begin_async(bool format_on_fail) {
+    if (_is_mounted || _mount_running()) {
+        return true;
+    }
+    
+    if (_mount_events == nullptr) {
+        // Cannot signal completion - fall back to mounting in place
+        return mount(format_on_fail);
+    }
+    
+    _mount_requested_us = esp_timer_get_time();
+    _mount_format_on_fail = format_on_fail;
+    xEventGroupClearBits(_mount_events, MOUNT_DONE_BIT);
+    _mount_pending = true;
+    
+    if (xTaskCreate(_mount_task, "storage_mount", _config.mount_task_stack_size, this,
+                    _config.mount_task_priority, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create mount task, mounting in place");
+        xEventGroupSetBits(_mount_events, MOUNT_DONE_BIT);
+        _mount_pending = false;
+        return mount(format_on_fail);
+    }
+    
+    return true;
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_mount_task(void* arg) {
+    STORAGE_ESP_CLASS* self = static_cast<STORAGE_ESP_CLASS*>(arg);
+    
+    self->mount(self->_mount_format_on_fail);
+    
+    // The bit is the last thing the task touches: the destructor may run as
+    // soon as it is set, so _mount_pending is left for callers to clear
+    xEventGroupSetBits(self->_mount_events, MOUNT_DONE_BIT);
+    vTaskDelete(NULL);
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::_mount_running() const {
+    return _mount_pending && (xEventGroupGetBits(_mount_events) & MOUNT_DONE_BIT) == 0;
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_await_mount() {
+    // Every public call starts here, so this also tells the idle scheduler
+    // that storage is busy - before the call starts waiting for the lock
+    _last_call_us = esp_timer_get_time();
+    
+    // Cheap once the first call after a background mount has seen it finish
+    if (_mount_pending) {
+        xEventGroupWaitBits(_mount_events, MOUNT_DONE_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
+        _mount_pending = false;
+    }
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::get_is_mounted() const {
+    if (_mount_pending) {
+        xEventGroupWaitBits(_mount_events, MOUNT_DONE_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+    return _is_mounted;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::wait_until_mounted(TickType_t timeout) {
+    if (_mount_pending) {
+        EventBits_t bits = xEventGroupWaitBits(_mount_events, MOUNT_DONE_BIT, pdFALSE, pdTRUE, timeout);
+        if ((bits & MOUNT_DONE_BIT) == 0) {
+            return false;
+        }
+    }
+    return _is_mounted;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::unmount() {
+    _await_mount();
+    stop_idle_gc();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    if (!_is_mounted) {
+        ESP_LOGW(TAG, "Storage not mounted");
+        return true;
+    }
+    
+    _evict_save();
+    _ttl_compact();
+    _expiry.clear();
+    _expiry_heap = decltype(_expiry_heap)();
+    
+    // A clean unmount needs no check unless one is still under way
+    _fsck_walk.reset();
+    if (_fsck_pending) {
+        _fsck_save();
+    } else if (_fsck_enabled() && !STORAGE_FAULT_POINT("fsck.cursor")) {
+        unlink(_get_full_path(STORAGE_FSCK_CURSOR_FILE).c_str());
+    }
+    
+#if STORAGE_ENABLE_METADATA_INDEX
+    _index_save();
+#endif
+    
+    bool ret = false;
+    
+    if (_storage_type == STORAGE_TYPE_SPIFFS) {
+#ifdef STORAGE_SPIFFS_AVAILABLE
+        ret = esp_vfs_spiffs_unregister(_partition_label.c_str()) == ESP_OK;
+#endif
+    } else {
+#ifdef STORAGE_LITTLEFS_AVAILABLE
+        ret = esp_vfs_littlefs_unregister(_partition_label.c_str()) == ESP_OK;
+#endif
+    }
+    
+    if (ret) {
+        if constexpr (LogPolicy::debug) {
+            ESP_LOGI(TAG, "%s unmounted successfully", _get_storage_type_name());
+        }
+        _is_mounted = false;
+        _dir_cache.clear();
+    } else {
+        ESP_LOGE(TAG, "Failed to unmount %s", _get_storage_type_name());
+    }
+    
+    return ret;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::format() {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    if (!_is_mounted) {
+        ESP_LOGE(TAG, "Storage not mounted, cannot format");
+        return false;
+    }
+    
+    bool ret = false;
+    
+    if (_storage_type == STORAGE_TYPE_SPIFFS) {
+#ifdef STORAGE_SPIFFS_AVAILABLE
+        ret = esp_spiffs_format(_partition_label.c_str()) == ESP_OK;
+#endif
+    } else {
+#ifdef STORAGE_LITTLEFS_AVAILABLE
+        ret = esp_littlefs_format(_partition_label.c_str()) == ESP_OK;
+#endif
+    }
+    
+    _dir_cache.clear();
+    for (auto& entry : _reservations) {
+        entry.second.size = 0;
+    }
+    for (auto& entry : _quotas) {
+        entry.second.used = 0;
+    }
+    _evictable.clear();
+    _lru.clear();
+    _expiry.clear();
+    _expiry_heap = decltype(_expiry_heap)();
+    _ttl_journal_records = 0;
+    _fsck_walk.reset();
+    _fsck_pending = false;
+    _fsck_cursor.clear();
+    if (ret && _fsck_enabled()) {
+        _fsck_save();
+    }
+    
+#if STORAGE_ENABLE_METADATA_INDEX
+    _index_rebuild.reset();
+    _index.clear();
+    // A freshly formatted filesystem is empty, so the empty index is complete
+    _index.set_valid(ret);
+    if (!ret) {
+        _index_start_rebuild();
+    }
+#endif
+    
+    if (ret) {
+        if constexpr (LogPolicy::debug) {
+            ESP_LOGI(TAG, "%s formatted successfully", _get_storage_type_name());
+        }
+    } else {
+        ESP_LOGE(TAG, "Failed to format %s", _get_storage_type_name());
+    }
+    
+    return ret;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::exists(const std::string& key) {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    if (!_is_mounted || _ttl_expired(key)) {
+        return false;
+    }
+    
+    return _stat_key(key, nullptr);
+}
+
+STORAGE_ESP_TEMPLATE
+size_t STORAGE_ESP_CLASS::file_size(const std::string& key) {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return 0;
+    }
+
+    if (!_is_mounted || _ttl_expired(key)) {
+        return 0;
+    }
+    
+    size_t size = 0;
+    _stat_key(key, &size);
+    return size;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::read_file(const std::string& key, void* data, size_t data_size) {
+    _await_mount();
+    return _read_file_internal(key, data, data_size);
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::write_file(const std::string& key, const void* data, size_t data_size) {
+    return write_file(key, data, data_size, storage_write_options_t());
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::write_file(const std::string& key, const void* data, size_t data_size,
+                                   const storage_write_options_t& options) {
+    if (_is_reserved_key(key)) {
+        return false;
+    }
+    if (options.ttl_seconds > 0 && time(nullptr) < STORAGE_TTL_MIN_CLOCK) {
+        // Before SNTP or the RTC sets the clock, an expiry computed from it
+        // would pass the moment the clock jumps forward
+        ESP_LOGE(TAG, "System clock not set, cannot expire %s", key.c_str());
+        return false;
+    }
+    _await_mount();
+
+    int64_t start_us = 0;
+    if constexpr (StatsPolicy::timed) {
+        start_us = esp_timer_get_time();
+    }
+
+    // Held across versioning too, so its archive writes keep the directory cache coherent
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    // Reap before the space checks below; peeking at the heap costs nothing
+    if (!_expiry_heap.empty() && _expiry_heap.top().first <= (uint32_t)time(nullptr)) {
+        _reap_locked(STORAGE_TTL_REAP_BATCH);
+    }
+
+    if (!_reservations.empty() || !_evictable.empty() || _quota_tracks(key)) {
+        size_t old_size = 0;
+        _stat_key(key, &old_size);
+        // Quota first: nothing should be evicted for a write that is refused anyway
+        if (!_quota_admit(key, old_size, data_size)) {
+            return false;
+        }
+        // With versioning the old contents move to an archive instead of
+        // being freed, so the whole new file needs room
+        size_t growth = _versioning_enabled() ? data_size : (data_size > old_size ? data_size - old_size : 0);
+        if (growth > 0) {
+            _evict_for(growth, key);
+        }
+        if (!_admit_growth(key, old_size, data_size)) {
+            return false;
+        }
+    }
+
+    if constexpr (VersionPolicy::enabled) {
+        // Notify versioning before write
+        if (_is_mounted && _versioning_enabled()) {
+            _init_versioning();
+            _versioning->on_before_write(key);
+        }
+    }
+    
+    bool ok = _write_file_no_mutex(key, data, data_size);
+    if constexpr (VersionPolicy::enabled) {
+        // Only now does the metadata move to the new version
+        if (ok && _versioning) {
+            _versioning->on_after_write(key, data, data_size);
+        }
+    }
+    if (ok && options.evictable) {
+        _evict_touch(key, true);
+    } else if (ok && !_evictable.empty()) {
+        // The class follows the latest write
+        _evict_forget_tree(_get_relative_dir(key));
+    }
+    if (ok && options.ttl_seconds > 0) {
+        _ttl_set(_get_relative_dir(key), (uint32_t)time(nullptr) + options.ttl_seconds);
+    } else if (ok && !_expiry.empty()) {
+        _ttl_forget_tree(_get_relative_dir(key));
+    }
+    if constexpr (StatsPolicy::timed) {
+        // Includes the lock wait, which is where a running collection shows up
+        _stats.on_write_latency(esp_timer_get_time() - start_us);
+    }
+    return ok;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::erase_file(const std::string& key) {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    return _erase_file_locked(key);
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::_erase_file_locked(const std::string& key) {
+    if (!_is_mounted) {
+        return false;
+    }
+    
+    std::string full_path = _get_file_path(key);
+    size_t old_size = 0;
+    if (_quota_tracks(key)) {
+        _stat_key(key, &old_size);
+    }
+    
+    if (!STORAGE_FAULT_POINT("erase") && unlink(full_path.c_str()) == 0) {
+        _cache_note_removed(key);
+        _quota_adjust(key, old_size, 0);
+        _stats.on_erase();
+        if constexpr (LogPolicy::debug) {
+            ESP_LOGD(TAG, "Deleted file: %s", key.c_str());
+        }
+        
+        if constexpr (VersionPolicy::enabled) {
+            // Also delete version metadata and every archived version
+            if (_versioning_enabled()) {
+                _init_versioning();
+                _versioning->remove_all_versions(key);
+            }
+        }
+        return true;
+    }
+    
+    ESP_LOGE(TAG, "Failed to delete file: %s", full_path.c_str());
+    return false;
+}
+
+STORAGE_ESP_TEMPLATE
+size_t STORAGE_ESP_CLASS::total_size() {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return 0;
+    }
+
+    if (!_is_mounted) {
+        return 0;
+    }
+    
+    size_t total = 0, used = 0;
+    _fs_info(total, used);
+    return total;
+}
+
+STORAGE_ESP_TEMPLATE
+size_t STORAGE_ESP_CLASS::used_size() {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return 0;
+    }
+
+    if (!_is_mounted) {
+        return 0;
+    }
+    
+    size_t total = 0, used = 0;
+    _fs_info(total, used);
+    
+    // Reserved space is as good as used to anyone else deciding whether to write
+    return std::min(total, used + _outstanding_reservations(""));
+}
+
+// ========== Internal File Operations ==========
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::_read_file_internal(const std::string& key, void* data, size_t data_size) {
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    if (!_is_mounted || !data) {
+        return false;
+    }
+    
+    if (_ttl_expired(key)) {
+        if constexpr (LogPolicy::debug) {
+            ESP_LOGD(TAG, "File expired: %s", key.c_str());
+        }
+        return false;
+    }
+    
+    std::string full_path = _get_file_path(key);
+    
+    FILE* f = fopen(full_path.c_str(), "rb");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open file for reading: %s", full_path.c_str());
+        return false;
+    }
+    
+    size_t bytes_read = fread(data, 1, data_size, f);
+    fclose(f);
+    _stats.on_read(bytes_read);
+    
+    // Note: It's normal for files to be smaller than the buffer size
+    // Only error if we read 0 bytes and the file should exist
+    if (bytes_read == 0 && data_size > 0) {
+        ESP_LOGE(TAG, "Failed to read any data from %s", key.c_str());
+        return false;
+    }
+    
+    _evict_touch(key, false);
+    
+    if constexpr (LogPolicy::debug) {
+        ESP_LOGD(TAG, "Read %zu bytes from %s (requested %zu)", bytes_read, key.c_str(), data_size);
+    }
+    return true;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::_write_file_internal(const std::string& key, const void* data, size_t data_size) {
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    if (!_is_mounted || !data) {
+        return false;
+    }
+    
+    std::string full_path = _get_file_path(key);
+    
+    // Create parent directories if needed
+    size_t last_slash = full_path.rfind('/');
+    if (last_slash != std::string::npos && last_slash > _base_path.length()) {
+        std::string dir_path = full_path.substr(0, last_slash);
+        _create_directory_recursive(dir_path);
+    }
+    
+    FILE* f = fopen(full_path.c_str(), "wb");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open file for writing: %s", full_path.c_str());
+        return false;
+    }
+    
+    size_t bytes_written = fwrite(data, 1, data_size, f);
+    fclose(f);
+    _stats.on_write(bytes_written);
+    
+    _cache_note_written(key, bytes_written);
+    
+    if (bytes_written != data_size) {
+        ESP_LOGE(TAG, "Write size mismatch: expected %zu, got %zu", data_size, bytes_written);
+        return false;
+    }
+    
+    if constexpr (LogPolicy::debug) {
+        ESP_LOGD(TAG, "Wrote %zu bytes to %s", bytes_written, key.c_str());
+    }
+    return true;
+}
+
+// Mutex-free version for internal callbacks to avoid deadlock
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::_write_file_no_mutex(const std::string& key, const void* data, size_t data_size) {
+    if (!_is_mounted || !data) {
+        return false;
+    }
+    
+    std::string full_path = _get_file_path(key);
+    size_t old_size = 0;
+    if (_quota_tracks(key)) {
+        _stat_key(key, &old_size);
+    }
+    
+    // Create parent directories if needed
+    size_t last_slash = full_path.rfind('/');
+    if (last_slash != std::string::npos && last_slash > _base_path.length()) {
+        std::string dir_path = full_path.substr(0, last_slash);
+        _create_directory_recursive(dir_path);
+    }
+    
+    if (STORAGE_FAULT_POINT("write.open")) {
+        return false;
+    }
+    FILE* f = fopen(full_path.c_str(), "wb");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open file for writing: %s", full_path.c_str());
+        return false;
+    }
+    
+    size_t bytes_written;
+    if (STORAGE_FAULT_POINT("write.data")) {
+        // Power lost mid-write: the file was truncated and half the data landed
+        fwrite(data, 1, data_size / 2, f);
+        fclose(f);
+        return false;
+    }
+    bytes_written = fwrite(data, 1, data_size, f);
+    fclose(f);
+    _stats.on_write(bytes_written);
+    
+    _cache_note_written(key, bytes_written);
+    _quota_adjust(key, old_size, bytes_written);
+    
+    if (bytes_written != data_size) {
+        ESP_LOGE(TAG, "Write size mismatch: expected %zu, got %zu", data_size, bytes_written);
+        return false;
+    }
+    
+    if constexpr (LogPolicy::debug) {
+        ESP_LOGD(TAG, "Wrote %zu bytes to %s", bytes_written, key.c_str());
+    }
+    return true;
+}
+
+// Mutex-free version for internal callbacks to avoid deadlock
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::_read_file_no_mutex(const std::string& key, void* data, size_t data_size) {
+    if (!_is_mounted || !data) {
+        return false;
+    }
+    
+    std::string full_path = _get_file_path(key);
+    
+    FILE* f = fopen(full_path.c_str(), "rb");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open file for reading: %s", full_path.c_str());
+        return false;
+    }
+    
+    size_t bytes_read = fread(data, 1, data_size, f);
+    fclose(f);
+    _stats.on_read(bytes_read);
+    
+    // Note: It's normal for files to be smaller than the buffer size
+    // Only error if we read 0 bytes and the file should exist
+    if (bytes_read == 0 && data_size > 0) {
+        ESP_LOGE(TAG, "Failed to read any data from %s", key.c_str());
+        return false;
+    }
+    
+    if constexpr (LogPolicy::debug) {
+        ESP_LOGD(TAG, "Read %zu bytes from %s (requested %zu)", bytes_read, key.c_str(), data_size);
+    }
+    return true;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::_read_file_range_no_mutex(const std::string& key, size_t offset, void* data, size_t data_size) {
+    if (!_is_mounted || !data) {
+        return false;
+    }
+    
+    std::string full_path = _get_file_path(key);
+    
+    FILE* f = fopen(full_path.c_str(), "rb");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open file for reading: %s", full_path.c_str());
+        return false;
+    }
+    
+    size_t bytes_read = 0;
+    if (fseek(f, offset, SEEK_SET) == 0) {
+        bytes_read = fread(data, 1, data_size, f);
+    }
+    fclose(f);
+    _stats.on_read(bytes_read);
+    
+    if (bytes_read != data_size) {
+        ESP_LOGE(TAG, "Short range read from %s: %zu of %zu bytes at %zu",
+                 key.c_str(), bytes_read, data_size, offset);
+        return false;
+    }
+    
+    return true;
+}
+
+// ========== Directory Operations ==========
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::_create_directory_recursive(const std::string& path) {
+    // Skip if path is just the base path
+    if (path == _base_path || path.length() <= _base_path.length()) {
+        return true;
+    }
+    
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0) {
+        return S_ISDIR(st.st_mode);
+    }
+    
+    // Create parent directory first
+    size_t last_slash = path.rfind('/');
+    if (last_slash != std::string::npos && last_slash > _base_path.length()) {
+        std::string parent = path.substr(0, last_slash);
+        if (!_create_directory_recursive(parent)) {
+            return false;
+        }
+    }
+    
+    // Create this directory
+    if (STORAGE_FAULT_POINT("mkdir")) {
+        return false;
+    }
+    if (mkdir(path.c_str(), STORAGE_DIR_PERMISSIONS) == 0) {
+        _cache_note_directory(path);
+        return true;
+    }
+    if (errno == EEXIST) {
+        return true;
+    }
+    
+    ESP_LOGE(TAG, "Failed to create directory: %s", path.c_str());
+    return false;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::create_directory(const std::string& path) {
+    if (_is_reserved_key(path)) {
+        return false;
+    }
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    if (!_is_mounted) {
+        return false;
+    }
+
+    std::string full_path = _get_full_path(path);
+    return _create_directory_recursive(full_path);
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::list_directory(const std::string& path, std::vector<file_info_t>& files,
+                                 uint32_t attributes) {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    if (!_is_mounted) {
+        return false;
+    }
+    
+    std::string dir_key = _get_relative_dir(path);
+    std::vector<file_info_t> entries;
+    
+    if (!_dir_cache.lookup(dir_key, attributes, entries)) {
+        walk_options_t options = _walk_options(dir_key.empty() ? "" : dir_key + "/");
+        options.recursive = false;
+        options.include_directories = true;
+        options.attributes = attributes;
+        
+        dir_walker walker(_base_path, options);
+        if (walker.done()) {
+            ESP_LOGE(TAG, "Failed to open directory: %s", _get_full_path(path).c_str());
+            return false;
+        }
+        
+        file_info_t info;
+        while (walker.next(info)) {
+            // Keep bare names so the cache can serve any spelling of the path
+            size_t last_slash = info.path.rfind('/');
+            if (last_slash != std::string::npos) {
+                info.path.erase(0, last_slash + 1);
+            }
+            entries.push_back(info);
+        }
+        
+        _dir_cache.store(dir_key, attributes, entries);
+    }
+    
+    // Cached entries hold bare names; report them under the caller's path
+    for (auto& info : entries) {
+        info.path = path + "/" + info.path;
+        files.push_back(std::move(info));
+    }
+    return true;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::list_directory_page(const std::string& path, dir_cursor_t& cursor, size_t max_entries,
+                                      std::vector<file_info_t>& files, uint32_t attributes) {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    if (!_is_mounted || max_entries == 0) {
+        return false;
+    }
+    
+    if (cursor._at_end) {
+        return true;
+    }
+    
+    std::string dir_key = _get_relative_dir(path);
+    
+    walk_options_t options = _walk_options(dir_key.empty() ? "" : dir_key + "/");
+    options.recursive = false;
+    options.include_directories = true;
+    // The type comes from d_type during the walk; sizes are stat()ed below,
+    // for the page only
+    options.attributes = attributes & STORAGE_ATTR_TYPE;
+    dir_walker walker(_base_path, options);
+    if (walker.done()) {
+        ESP_LOGE(TAG, "Failed to open directory: %s", _get_full_path(path).c_str());
+        return false;
+    }
+    
+    // Keep the max_entries smallest names after the cursor in a max-heap,
+    // so one readdir pass yields the page without holding the whole directory
+    auto by_name = [](const file_info_t& a, const file_info_t& b) { return a.path < b.path; };
+    std::vector<file_info_t> page;
+    page.reserve(max_entries);
+    bool more_remaining = false;
+    
+    file_info_t entry;
+    while (walker.next(entry)) {
+        if (!cursor._last_name.empty() && entry.path <= cursor._last_name) {
+            continue;
+        }
+        
+        if (page.size() < max_entries) {
+            page.push_back(entry);
+            std::push_heap(page.begin(), page.end(), by_name);
+        } else {
+            more_remaining = true;
+            if (entry.path < page.front().path) {
+                std::pop_heap(page.begin(), page.end(), by_name);
+                page.back() = entry;
+                std::push_heap(page.begin(), page.end(), by_name);
+            }
+        }
+    }
+    
+    std::sort_heap(page.begin(), page.end(), by_name);
+    
+    for (auto& info : page) {
+        bool need_size = (attributes & STORAGE_ATTR_SIZE) && !info.is_directory;
+        if (need_size) {
+            file_info_t sized;
+            if (!_read_entry_attributes(info.path, STORAGE_ATTR_SIZE, sized)) {
+                continue;
+            }
+            info.size = sized.size;
+            info.is_directory = sized.is_directory;
+        }
+        files.push_back(info);
+    }
+    
+    if (!page.empty()) {
+        cursor._last_name = page.back().path;
+    }
+    cursor._at_end = !more_remaining;
+    
+    return true;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::list_all_files(std::vector<file_info_t>& files) {
+    return for_each_file([&files](const file_info_t& info) {
+        files.push_back(info);
+        return true;
+    });
+}
+
+// ========== Streaming Enumeration ==========
+
+STORAGE_ESP_TEMPLATE
+dir_walker STORAGE_ESP_CLASS::walk_files(const std::string& prefix) const {
+    return dir_walker(_base_path, _walk_options(prefix));
+}
+
+STORAGE_ESP_TEMPLATE
+dir_walker STORAGE_ESP_CLASS::walk(const walk_options_t& options) const {
+    walk_options_t mapped = options;
+    mapped.fanout = _key_fanout;
+    return dir_walker(_base_path, mapped);
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::for_each_file(const file_visitor_t& visitor, const std::string& prefix) {
+    _await_mount();
+
+    if (!_is_mounted || !visitor) {
+        return false;
+    }
+    
+    dir_walker walker = walk_files(prefix);
+    file_info_t info;
+    while (walker.next(info)) {
+        if (!visitor(info)) {
+            break;
+        }
+    }
+    
+    return true;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::for_each_match(const std::string& pattern, const file_visitor_t& visitor) {
+    _await_mount();
+
+    if (!_is_mounted || !visitor) {
+        return false;
+    }
+    
+    walk_options_t options;
+    options.pattern = pattern;
+    dir_walker walker = walk(options);
+    
+    file_info_t info;
+    while (walker.next(info)) {
+        if (!visitor(info)) {
+            break;
+        }
+    }
+    
+    return true;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::list_matching(const std::string& pattern, std::vector<file_info_t>& files) {
+    return for_each_match(pattern, [&files](const file_info_t& info) {
+        files.push_back(info);
+        return true;
+    });
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::for_each_file_parallel(const file_visitor_t& visitor, const std::string& prefix,
+                                         size_t num_workers) {
+    _await_mount();
+
+    if (!_is_mounted || !visitor) {
+        return false;
+    }
+    
+    parallel_walker walker(_base_path, num_workers);
+    walker.run(visitor, _walk_options(prefix));
+    return true;
+}
+
+// ========== Bulk Operations ==========
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::_is_version_artifact(const std::string& name) {
+    static const std::string meta_ext = STORAGE_VERSION_METADATA_EXT;
+    if (name.length() > meta_ext.length() &&
+        name.compare(name.length() - meta_ext.length(), meta_ext.length(), meta_ext) == 0) {
+        return true;
+    }
+    
+    // <key>.v<digits> (full archive) or <key>.p<digits> (patch archive)
+    size_t dot = name.rfind('.');
+    if (dot == std::string::npos || dot + 2 >= name.length() ||
+        (name[dot + 1] != 'v' && name[dot + 1] != 'p')) {
+        return false;
+    }
+    return name.find_first_not_of("0123456789", dot + 2) == std::string::npos;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::_remove_tree_locked(const std::string& full_path, storage_tree_stats_t& stats) {
+    bool ok = true;
+    
+    // Read a batch of names, close the directory, then delete them, so no
+    // entry is removed while readdir() is positioned inside the same directory.
+    // Emptying the root leaves the driver's own files in place.
+    bool at_root = full_path == _get_full_path("");
+    while (true) {
+        DIR* dir = opendir(full_path.c_str());
+        if (!dir) {
+            ESP_LOGE(TAG, "Failed to open directory: %s", full_path.c_str());
+            return false;
+        }
+        
+        std::vector<std::string> batch;
+        struct dirent* entry;
+        while (batch.size() < _config.tree_batch_size && (entry = readdir(dir)) != NULL) {
+            if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0 &&
+                !(at_root && dir_walker::is_reserved("", entry->d_name))) {
+                batch.push_back(entry->d_name);
+            }
+        }
+        closedir(dir);
+        
+        if (batch.empty()) {
+            break;
+        }
+        
+        bool progress = false;
+        for (const auto& name : batch) {
+            std::string entry_path = full_path + "/" + name;
+            struct stat st;
+            if (stat(entry_path.c_str(), &st) != 0) {
+                continue;
+            }
+            
+            if (S_ISDIR(st.st_mode)) {
+                // Buckets are removed like any other directory but not reported
+                bool is_bucket = _key_fanout && key_fanout::is_bucket(name.c_str());
+                if (_remove_tree_locked(entry_path, stats) && rmdir(entry_path.c_str()) == 0) {
+                    if (!is_bucket) {
+                        stats.directories++;
+                    }
+                    progress = true;
+                } else {
+                    ok = false;
+                }
+            } else if (!STORAGE_FAULT_POINT("erase") && unlink(entry_path.c_str()) == 0) {
+                if (_is_version_artifact(name)) {
+                    stats.version_files++;
+                } else {
+                    stats.files++;
+                }
+                stats.bytes += st.st_size;
+                progress = true;
+            } else {
+                ESP_LOGE(TAG, "Failed to delete file: %s", entry_path.c_str());
+                ok = false;
+            }
+        }
+        
+        if (!progress) {
+            // Everything left is undeletable - stop rather than spin
+            break;
+        }
+    }
+    
+    return ok;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::remove_tree(const std::string& path, storage_tree_stats_t* stats) {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    if (!_is_mounted) {
+        return false;
+    }
+    
+    std::string dir_key = _get_relative_dir(path);
+    std::string full_path = _get_full_path(dir_key);
+    
+    struct stat st;
+    if (stat(full_path.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+        ESP_LOGE(TAG, "Not a directory: %s", path.c_str());
+        return false;
+    }
+    
+#if STORAGE_ENABLE_METADATA_INDEX
+    // A rebuild walk may hold directories open inside the tree
+    bool restart_index = (bool)_index_rebuild;
+    _index_rebuild.reset();
+#endif
+    // So may the checker's; it resumes from its cursor
+    _fsck_walk.reset();
+    
+    storage_tree_stats_t removed;
+    bool ok = _remove_tree_locked(full_path, removed);
+    
+    if (ok && !dir_key.empty()) {
+        ok = rmdir(full_path.c_str()) == 0;
+        if (ok) {
+            removed.directories++;
+        }
+    }
+    
+    if (dir_key.empty()) {
+        // Only the driver's own files are left, so drop all per-key state as
+        // format() does; with no expiry times left the journal is deleted
+        _gc_needed = true;
+        _dir_cache.clear();
+        for (auto& entry : _reservations) {
+            entry.second.size = 0;
+        }
+        _evictable.clear();
+        _lru.clear();
+        if (!_expiry.empty()) {
+            _expiry.clear();
+            _expiry_heap = decltype(_expiry_heap)();
+            _ttl_compact();
+        }
+#if STORAGE_ENABLE_METADATA_INDEX
+        _index.clear();
+#endif
+    } else {
+        _cache_note_removed(dir_key);
+    }
+    _quota_note_tree_removed(dir_key, removed.bytes);
+    
+#if STORAGE_ENABLE_METADATA_INDEX
+    if (restart_index || !ok) {
+        // A partial removal leaves the index unsure of what survived
+        _index_start_rebuild();
+    }
+#endif
+    
+    if constexpr (LogPolicy::debug) {
+        ESP_LOGI(TAG, "Removed %s: %u files, %u version files, %u directories, %llu bytes",
+                 path.c_str(), (unsigned)removed.files, (unsigned)removed.version_files,
+                 (unsigned)removed.directories, (unsigned long long)removed.bytes);
+    }
+    
+    if (stats) {
+        *stats = removed;
+    }
+    return ok;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::erase_prefix(const std::string& prefix, storage_tree_stats_t* stats) {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    if (!_is_mounted) {
+        return false;
+    }
+    
+#if STORAGE_ENABLE_METADATA_INDEX
+    // A rebuild walk may hold directories open below the prefix
+    bool restart_index = (bool)_index_rebuild;
+    _index_rebuild.reset();
+#endif
+    // So may the checker's; it resumes from its cursor
+    _fsck_walk.reset();
+    
+    storage_tree_stats_t removed;
+    bool ok = true;
+    
+    // A key's .meta and .vN files share its prefix, so walking the prefix
+    // catches them along with the data. One walk covers the whole prefix:
+    // LittleFS and SPIFFS keep an open directory's position when entries it
+    // has already returned are unlinked, and only those are. A file that
+    // fails to unlink is simply left behind.
+    dir_walker walker = walk_files(prefix);
+    file_info_t info;
+    while (walker.next(info)) {
+        if (STORAGE_FAULT_POINT("erase") || unlink(_get_file_path(info.path).c_str()) != 0) {
+            ESP_LOGE(TAG, "Failed to delete file: %s", info.path.c_str());
+            ok = false;
+            continue;
+        }
+        
+        _cache_note_removed(info.path);
+        _quota_adjust(info.path, info.size, 0);
+        _stats.on_erase();
+        
+        size_t last_slash = info.path.rfind('/');
+        std::string name = (last_slash == std::string::npos) ? info.path : info.path.substr(last_slash + 1);
+        if (_is_version_artifact(name)) {
+            removed.version_files++;
+        } else {
+            removed.files++;
+        }
+        removed.bytes += info.size;
+    }
+    
+#if STORAGE_ENABLE_METADATA_INDEX
+    if (restart_index) {
+        _index_start_rebuild();
+    }
+#endif
+    
+    if constexpr (LogPolicy::debug) {
+        ESP_LOGI(TAG, "Erased prefix %s: %u files, %u version files, %llu bytes",
+                 prefix.c_str(), (unsigned)removed.files, (unsigned)removed.version_files,
+                 (unsigned long long)removed.bytes);
+    }
+    
+    if (stats) {
+        *stats = removed;
+    }
+    return ok;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::usage(const std::string& path, storage_tree_stats_t& stats) {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    stats = storage_tree_stats_t();
+    
+    if (!_is_mounted) {
+        return false;
+    }
+    
+    std::string dir_key = _get_relative_dir(path);
+    walk_options_t options = _walk_options(dir_key.empty() ? "" : dir_key + "/");
+    options.include_directories = true;
+    
+    dir_walker walker(_base_path, options);
+    if (walker.done()) {
+        ESP_LOGE(TAG, "Failed to open directory: %s", _get_full_path(path).c_str());
+        return false;
+    }
+    
+    file_info_t info;
+    while (walker.next(info)) {
+        if (info.is_directory) {
+            stats.directories++;
+            continue;
+        }
+        
+        size_t last_slash = info.path.rfind('/');
+        std::string name = (last_slash == std::string::npos) ? info.path : info.path.substr(last_slash + 1);
+        if (_is_version_artifact(name)) {
+            stats.version_files++;
+        } else {
+            stats.files++;
+        }
+        stats.bytes += info.size;
+    }
+    
+    return true;
+}
+
+// ========== Key Mapping ==========
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::set_key_fanout(bool enable) {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    // Cached listings were read under the old layout
+    _key_fanout = enable;
+    _dir_cache.clear();
+    return true;
+}
+
+// ========== Space Reservations ==========
+
+STORAGE_ESP_TEMPLATE
+size_t STORAGE_ESP_CLASS::_outstanding_reservations(const std::string& except) const {
+    size_t outstanding = 0;
+    for (const auto& entry : _reservations) {
+        if (entry.first != except && entry.second.reserved > entry.second.size) {
+            outstanding += entry.second.reserved - entry.second.size;
+        }
+    }
+    return outstanding;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::_admit_growth(const std::string& key, size_t old_size, size_t new_size) {
+    std::string reserved_key = _get_relative_dir(key);
+    size_t growth = new_size > old_size ? new_size - old_size : 0;
+    
+    // Growth inside the file's own reservation was accounted for when it was made
+    auto own = _reservations.find(reserved_key);
+    if (own != _reservations.end() && new_size <= own->second.reserved) {
+        return true;
+    }
+    
+    size_t others = _outstanding_reservations(reserved_key);
+    if (growth == 0 || others == 0) {
+        return true;
+    }
+    
+    size_t total = 0, used = 0;
+    if (!_fs_info(total, used)) {
+        return false;
+    }
+    
+    size_t free_bytes = total > used ? total - used : 0;
+    if (free_bytes < others + growth) {
+        ESP_LOGE(TAG, "Write to %s needs %zu bytes, only %zu free outside %zu reserved",
+                 key.c_str(), growth, free_bytes > others ? free_bytes - others : 0, others);
+        return false;
+    }
+    return true;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::reserve(const std::string& key, size_t bytes) {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    if (!_is_mounted) {
+        return false;
+    }
+    
+    std::string reserved_key = _get_relative_dir(key);
+    size_t current = 0;
+    _stat_key(key, &current);
+    
+    size_t needed = bytes > current ? bytes - current : 0;
+    size_t others = _outstanding_reservations(reserved_key);
+    size_t total = 0, used = 0;
+    if (!_fs_info(total, used)) {
+        ESP_LOGE(TAG, "Failed to get filesystem info for reservation");
+        return false;
+    }
+    
+    size_t free_bytes = total > used ? total - used : 0;
+    if (free_bytes < others + needed) {
+        ESP_LOGE(TAG, "Cannot reserve %zu bytes for %s: %zu free, %zu already reserved",
+                 needed, key.c_str(), free_bytes, others);
+        return false;
+    }
+    
+    _reservations[reserved_key] = {bytes, current};
+    
+    if constexpr (LogPolicy::debug) {
+        ESP_LOGD(TAG, "Reserved %zu bytes for %s (%zu written)", bytes, key.c_str(), current);
+    }
+    return true;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::release(const std::string& key, size_t final_size) {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    _reservations.erase(_get_relative_dir(key));
+    
+    if (final_size == SIZE_MAX || !_is_mounted) {
+        return _is_mounted;
+    }
+    return _truncate_locked(key, final_size);
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_reservation_rename(const std::string& old_key, const std::string& new_key) {
+    if (_reservations.empty() || old_key == new_key) {
+        return;
+    }
+    
+    // A renamed directory takes the reservations of everything below it along
+    std::string old_prefix = old_key + "/";
+    std::vector<std::pair<std::string, reservation>> moved;
+    for (auto it = _reservations.begin(); it != _reservations.end();) {
+        if (it->first == old_key) {
+            moved.push_back({new_key, it->second});
+        } else if (it->first.compare(0, old_prefix.length(), old_prefix) == 0) {
+            moved.push_back({new_key + "/" + it->first.substr(old_prefix.length()), it->second});
+        } else {
+            ++it;
+            continue;
+        }
+        it = _reservations.erase(it);
+    }
+    
+    for (const auto& entry : moved) {
+        _reservations[entry.first] = entry.second;
+    }
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::truncate_file(const std::string& key, size_t size) {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    if (!_is_mounted) {
+        return false;
+    }
+    
+    return _truncate_locked(key, size);
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::_truncate_locked(const std::string& key, size_t size) {
+    size_t current = 0;
+    if (!_stat_key(key, &current)) {
+        ESP_LOGE(TAG, "File not found: %s", key.c_str());
+        return false;
+    }
+    if (size >= current) {
+        return true;
+    }
+    
+    if constexpr (VersionPolicy::enabled) {
+        // The cut tail is the span this "write" replaces
+        if (_versioning_enabled()) {
+            _init_versioning();
+            if (!_versioning->on_before_write_range(key, size, current - size)) {
+                return false;
+            }
+        }
+    }
+    
+    std::string full_path = _get_file_path(key);
+    if (STORAGE_FAULT_POINT("truncate")) {
+        return false;
+    }
+    bool ok = truncate(full_path.c_str(), size) == 0;
+    
+    if (!ok) {
+        // Older SPIFFS VFS builds have no truncate(): copy the kept prefix to a
+        // temporary file and swap it in
+        std::string temp_path = full_path + ".trunc";
+        FILE* src = fopen(full_path.c_str(), "rb");
+        FILE* dst = src ? fopen(temp_path.c_str(), "wb") : NULL;
+        
+        std::vector<uint8_t> buffer(_config.checksum_buffer_size);
+        size_t remaining = size;
+        while (src && dst && remaining > 0) {
+            size_t chunk = std::min(remaining, buffer.size());
+            if (fread(buffer.data(), 1, chunk, src) != chunk || fwrite(buffer.data(), 1, chunk, dst) != chunk) {
+                break;
+            }
+            remaining -= chunk;
+        }
+        
+        if (src) {
+            fclose(src);
+        }
+        if (dst) {
+            fclose(dst);
+        }
+        _stats.on_read(size - remaining);
+        _stats.on_write(size - remaining);
+        
+        // SPIFFS will not rename over an existing file. Once the original is
+        // gone the temporary copy is the only one, so it is kept on failure.
+        if (dst && remaining == 0 && unlink(full_path.c_str()) == 0) {
+            ok = rename(temp_path.c_str(), full_path.c_str()) == 0;
+            if (!ok) {
+                ESP_LOGE(TAG, "Truncated copy of %s left at %s", key.c_str(), temp_path.c_str());
+            }
+        } else {
+            unlink(temp_path.c_str());
+        }
+    }
+    
+    if (!ok) {
+        ESP_LOGE(TAG, "Failed to truncate %s to %zu bytes", key.c_str(), size);
+        return false;
+    }
+    
+    _cache_note_written(key, size);
+    _quota_adjust(key, current, size);
+    
+    if constexpr (VersionPolicy::enabled) {
+        if (_versioning) {
+            _versioning->on_after_write_range(key);
+        }
+    }
+    
+    if constexpr (LogPolicy::debug) {
+        ESP_LOGD(TAG, "Truncated %s from %zu to %zu bytes", key.c_str(), current, size);
+    }
+    return true;
+}
+
+STORAGE_ESP_TEMPLATE
+size_t STORAGE_ESP_CLASS::get_reserved_bytes() {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return 0;
+    }
+
+    return _outstanding_reservations("");
+}
+
+// ========== Quotas ==========
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::_quota_tracks(const std::string& key) const {
+    if (_quotas.empty()) {
+        return false;
+    }
+    std::string relative_key = _get_relative_dir(key);
+    for (const auto& entry : _quotas) {
+        if (_quota_matches(entry.first, relative_key)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::_quota_admit(const std::string& key, size_t old_size, size_t new_size) const {
+    if (_quotas.empty() || new_size <= old_size) {
+        return true;
+    }
+    
+    std::string relative_key = _get_relative_dir(key);
+    for (const auto& entry : _quotas) {
+        if (_quota_matches(entry.first, relative_key) &&
+            entry.second.used + (new_size - old_size) > entry.second.limit) {
+            ESP_LOGE(TAG, "Write to %s rejected: quota %s at %llu of %zu bytes", key.c_str(),
+                     entry.first.c_str(), (unsigned long long)entry.second.used, entry.second.limit);
+            return false;
+        }
+    }
+    return true;
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_quota_adjust(const std::string& key, size_t old_size, size_t new_size) {
+    if (_quotas.empty() || old_size == new_size) {
+        return;
+    }
+    
+    std::string relative_key = _get_relative_dir(key);
+    for (auto& entry : _quotas) {
+        if (!_quota_matches(entry.first, relative_key)) {
+            continue;
+        }
+        uint64_t& used = entry.second.used;
+        used = (new_size > old_size) ? used + (new_size - old_size)
+                                     : used - std::min(used, (uint64_t)(old_size - new_size));
+    }
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_quota_note_tree_removed(const std::string& dir_key, uint64_t bytes) {
+    std::string tree_prefix = dir_key.empty() ? "" : dir_key + "/";
+    for (auto& entry : _quotas) {
+        uint64_t& used = entry.second.used;
+        if (_quota_matches(tree_prefix, entry.first)) {
+            // Everything under the quota was inside the removed tree
+            used = 0;
+        } else if (_quota_matches(entry.first, tree_prefix)) {
+            used -= std::min(used, bytes);
+        }
+    }
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_quota_recount(const std::string& prefix, quota& entry) {
+    entry.used = 0;
+    if (!_is_mounted) {
+        return;
+    }
+    
+    dir_walker walker(_base_path, _walk_options(prefix));
+    file_info_t info;
+    while (walker.next(info)) {
+        entry.used += info.size;
+    }
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::set_quota(const std::string& prefix, size_t limit_bytes) {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    // Leading slashes are ignored as in keys; a trailing one is kept so
+    // "logs/" does not also cover "logs_old"
+    size_t start = prefix.find_first_not_of('/');
+    std::string normalized = (start == std::string::npos) ? "" : prefix.substr(start);
+    
+    auto it = _quotas.find(normalized);
+    if (it != _quotas.end()) {
+        it->second.limit = limit_bytes;
+        return true;
+    }
+    
+    quota entry = {limit_bytes, 0};
+    _quota_recount(normalized, entry);
+    _quotas[normalized] = entry;
+    
+    if (entry.used > limit_bytes) {
+        ESP_LOGW(TAG, "Quota %s already exceeded: %llu of %zu bytes", normalized.c_str(),
+                 (unsigned long long)entry.used, limit_bytes);
+    }
+    if constexpr (LogPolicy::debug) {
+        ESP_LOGI(TAG, "Quota %s: %llu of %zu bytes used", normalized.c_str(),
+                 (unsigned long long)entry.used, limit_bytes);
+    }
+    return true;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::remove_quota(const std::string& prefix) {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    size_t start = prefix.find_first_not_of('/');
+    return _quotas.erase(start == std::string::npos ? "" : prefix.substr(start)) > 0;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::get_quota(const std::string& prefix, uint64_t& used, size_t& limit) {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    size_t start = prefix.find_first_not_of('/');
+    auto it = _quotas.find(start == std::string::npos ? "" : prefix.substr(start));
+    if (it == _quotas.end()) {
+        return false;
+    }
+    used = it->second.used;
+    limit = it->second.limit;
+    return true;
+}
+
+// ========== Evictable Files ==========
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_evict_touch(const std::string& key, bool insert) {
+    if (_evictable.empty() && !insert) {
+        return;
+    }
+    
+    std::string relative_key = _get_relative_dir(key);
+    auto it = _evictable.find(relative_key);
+    if (it != _evictable.end()) {
+        _lru.splice(_lru.begin(), _lru, it->second);
+    } else if (insert) {
+        _lru.push_front(relative_key);
+        _evictable[relative_key] = _lru.begin();
+    }
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_evict_forget_tree(const std::string& relative_key) {
+    auto it = _evictable.find(relative_key);
+    if (it != _evictable.end()) {
+        _lru.erase(it->second);
+        _evictable.erase(it);
+    }
+    
+    // A removed directory takes its evictable files with it
+    std::string prefix = relative_key.empty() ? "" : relative_key + "/";
+    for (it = _evictable.lower_bound(prefix); it != _evictable.end() &&
+         it->first.compare(0, prefix.length(), prefix) == 0;) {
+        _lru.erase(it->second);
+        it = _evictable.erase(it);
+    }
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_evict_rename(const std::string& old_key, const std::string& new_key) {
+    if (_evictable.empty()) {
+        return;
+    }
+    
+    // Renamed entries keep their place in the recency order
+    std::string old_prefix = old_key + "/";
+    std::vector<std::pair<std::string, std::list<std::string>::iterator>> moved;
+    for (auto it = _evictable.begin(); it != _evictable.end();) {
+        if (it->first == old_key) {
+            moved.push_back({new_key, it->second});
+        } else if (it->first.compare(0, old_prefix.length(), old_prefix) == 0) {
+            moved.push_back({new_key + "/" + it->first.substr(old_prefix.length()), it->second});
+        } else {
+            ++it;
+            continue;
+        }
+        it = _evictable.erase(it);
+    }
+    
+    for (auto& entry : moved) {
+        *entry.second = entry.first;
+        auto existing = _evictable.find(entry.first);
+        if (existing != _evictable.end()) {
+            _lru.erase(existing->second);
+        }
+        _evictable[entry.first] = entry.second;
+    }
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_evict_for(size_t bytes, const std::string& writing_key) {
+    if (_evictable.empty()) {
+        return;
+    }
+    
+    size_t total = 0, used = 0;
+    if (!_fs_info(total, used)) {
+        return;
+    }
+    
+    // Block-granular allocation means "just enough" is not enough; keep some headroom
+    size_t needed = bytes + STORAGE_EVICT_HEADROOM_BYTES;
+    std::string writing = _get_relative_dir(writing_key);
+    auto victim = _lru.end();
+    
+    while (total - std::min(total, used) < needed && victim != _lru.begin()) {
+        --victim;
+        if (*victim == writing) {
+            continue;  // About to be replaced anyway
+        }
+        
+        std::string key = *victim;
+        ++victim;  // The erase below drops the victim's node
+        if (!_erase_file_locked(key)) {
+            // Already gone or undeletable - stop tracking it either way
+            _evict_forget_tree(key);
+        }
+        _evictions++;
+        
+        if constexpr (LogPolicy::debug) {
+            ESP_LOGI(TAG, "Evicted %s to make room for %s", key.c_str(), writing_key.c_str());
+        }
+        
+        if (!_fs_info(total, used)) {
+            return;
+        }
+    }
+    
+    if (total - std::min(total, used) < needed) {
+        ESP_LOGW(TAG, "Evicted every cache file but %s still may not fit", writing_key.c_str());
+    }
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_evict_load() {
+    std::string snapshot_path = _get_full_path(STORAGE_EVICT_SNAPSHOT_FILE);
+    FILE* f = fopen(snapshot_path.c_str(), "r");
+    if (!f) {
+        return;
+    }
+    
+    std::string contents;
+    char buffer[128];
+    size_t length;
+    while ((length = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        contents.append(buffer, length);
+    }
+    fclose(f);
+    
+    // Most recently used first, one key per line
+    size_t start = 0;
+    while (start < contents.length()) {
+        size_t end = contents.find('\n', start);
+        if (end == std::string::npos) {
+            end = contents.length();
+        }
+        std::string key = contents.substr(start, end - start);
+        start = end + 1;
+        
+        if (!key.empty() && _evictable.count(key) == 0 && _stat_key(key, nullptr)) {
+            _lru.push_back(key);
+            _evictable[key] = std::prev(_lru.end());
+        }
+    }
+    
+    // As with the metadata index: after a crash the set is gone rather than
+    // stale, so a file rewritten as permanent can never be evicted by mistake
+    unlink(snapshot_path.c_str());
+    
+    if constexpr (LogPolicy::debug) {
+        ESP_LOGI(TAG, "Loaded %u evictable files", (unsigned)_evictable.size());
+    }
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_evict_save() {
+    if (_lru.empty()) {
+        return;
+    }
+    
+    std::string snapshot_path = _get_full_path(STORAGE_EVICT_SNAPSHOT_FILE);
+    FILE* f = STORAGE_FAULT_POINT("evict.snapshot") ? NULL : fopen(snapshot_path.c_str(), "w");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to save evictable set: %s", snapshot_path.c_str());
+        return;
+    }
+    
+    bool ok = true;
+    for (const auto& key : _lru) {
+        ok = ok && fputs(key.c_str(), f) >= 0 && fputc('\n', f) != EOF;
+    }
+    ok = (fclose(f) == 0) && ok;
+    
+    if (!ok) {
+        ESP_LOGE(TAG, "Failed to save evictable set: %s", snapshot_path.c_str());
+        unlink(snapshot_path.c_str());
+    }
+    _lru.clear();
+    _evictable.clear();
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::is_evictable(const std::string& key) {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    return _evictable.count(_get_relative_dir(key)) > 0;
+}
+
+STORAGE_ESP_TEMPLATE
+size_t STORAGE_ESP_CLASS::get_evictable_count() {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return 0;
+    }
+
+    return _evictable.size();
+}
+
+// ========== Expiring Files ==========
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::_ttl_expired(const std::string& key) const {
+    if (_expiry.empty()) {
+        return false;
+    }
+    auto it = _expiry.find(_get_relative_dir(key));
+    return it != _expiry.end() && it->second <= (uint32_t)time(nullptr);
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_ttl_set(const std::string& relative_key, uint32_t expires) {
+    _expiry[relative_key] = expires;
+    _expiry_heap.push({expires, relative_key});
+    _ttl_prune_heap();
+    _ttl_journal({{expires, relative_key}});
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_ttl_prune_heap() {
+    // Rewrites, renames and removals leave their old heap entries behind;
+    // rebuild from the map before they pile up
+    if (_expiry_heap.size() <= 2 * _expiry.size() + 32) {
+        return;
+    }
+    std::vector<expiry_entry> live;
+    live.reserve(_expiry.size());
+    for (const auto& entry : _expiry) {
+        live.push_back({entry.second, entry.first});
+    }
+    _expiry_heap = decltype(_expiry_heap)(std::greater<expiry_entry>(), std::move(live));
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_ttl_forget_tree(const std::string& relative_key) {
+    // Heap entries are left to go stale; the reaper skips them
+    std::vector<expiry_entry> cleared;
+    auto it = _expiry.find(relative_key);
+    if (it != _expiry.end()) {
+        cleared.push_back({0, it->first});
+        _expiry.erase(it);
+    }
+    
+    std::string prefix = relative_key.empty() ? "" : relative_key + "/";
+    for (it = _expiry.lower_bound(prefix); it != _expiry.end() &&
+         it->first.compare(0, prefix.length(), prefix) == 0;) {
+        cleared.push_back({0, it->first});
+        it = _expiry.erase(it);
+    }
+    
+    if (!cleared.empty()) {
+        _ttl_journal(cleared);
+    }
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_ttl_rename(const std::string& old_key, const std::string& new_key) {
+    if (_expiry.empty()) {
+        return;
+    }
+    
+    std::string old_prefix = old_key + "/";
+    std::vector<expiry_entry> records;
+    std::vector<expiry_entry> moved;
+    for (auto it = _expiry.begin(); it != _expiry.end();) {
+        if (it->first == old_key) {
+            moved.push_back({it->second, new_key});
+        } else if (it->first.compare(0, old_prefix.length(), old_prefix) == 0) {
+            moved.push_back({it->second, new_key + "/" + it->first.substr(old_prefix.length())});
+        } else {
+            ++it;
+            continue;
+        }
+        records.push_back({0, it->first});
+        it = _expiry.erase(it);
+    }
+    
+    for (const auto& entry : moved) {
+        _expiry[entry.second] = entry.first;
+        _expiry_heap.push(entry);
+        records.push_back(entry);
+    }
+    
+    if (!records.empty()) {
+        _ttl_journal(records);
+    }
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_ttl_journal(const std::vector<expiry_entry>& records) {
+    // Appending keeps a TTL change to one small write; expires 0 clears a key.
+    // Records are {u32 expires, u16 key length, key}.
+    std::string journal_path = _get_full_path(STORAGE_TTL_JOURNAL_FILE);
+    FILE* f = STORAGE_FAULT_POINT("ttl.journal") ? NULL : fopen(journal_path.c_str(), "ab");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open TTL journal: %s", journal_path.c_str());
+        return;
+    }
+    
+    bool ok = true;
+    if (ftell(f) == 0) {
+        uint32_t magic = TTL_JOURNAL_MAGIC;
+        ok = fwrite(&magic, sizeof(magic), 1, f) == 1;
+    }
+    for (const auto& record : records) {
+        uint16_t key_length = (uint16_t)record.second.length();
+        ok = ok && fwrite(&record.first, sizeof(record.first), 1, f) == 1 &&
+             fwrite(&key_length, sizeof(key_length), 1, f) == 1 &&
+             fwrite(record.second.data(), 1, key_length, f) == key_length;
+    }
+    ok = (fclose(f) == 0) && ok;
+    
+    if (!ok) {
+        ESP_LOGE(TAG, "Failed to append to TTL journal: %s", journal_path.c_str());
+    }
+    
+    _ttl_journal_records += records.size();
+    if (_ttl_journal_records > 2 * _expiry.size() + 32) {
+        _ttl_compact();
+    }
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_ttl_compact() {
+    std::string journal_path = _get_full_path(STORAGE_TTL_JOURNAL_FILE);
+    std::string temp_path = journal_path + ".tmp";
+    _ttl_journal_records = 0;
+    
+    if (_expiry.empty()) {
+        unlink(journal_path.c_str());
+        return;
+    }
+    
+    FILE* f = STORAGE_FAULT_POINT("ttl.compact") ? NULL : fopen(temp_path.c_str(), "wb");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to compact TTL journal: %s", temp_path.c_str());
+        return;
+    }
+    
+    uint32_t magic = TTL_JOURNAL_MAGIC;
+    bool ok = fwrite(&magic, sizeof(magic), 1, f) == 1;
+    for (const auto& entry : _expiry) {
+        uint16_t key_length = (uint16_t)entry.first.length();
+        ok = ok && fwrite(&entry.second, sizeof(entry.second), 1, f) == 1 &&
+             fwrite(&key_length, sizeof(key_length), 1, f) == 1 &&
+             fwrite(entry.first.data(), 1, key_length, f) == key_length;
+    }
+    ok = (fclose(f) == 0) && ok;
+    
+    // SPIFFS will not rename over an existing file. _ttl_load() picks up the
+    // temporary file if power fails between the two steps.
+    if (!ok || STORAGE_FAULT_POINT("ttl.swap") || (unlink(journal_path.c_str()) != 0 && errno != ENOENT) ||
+        rename(temp_path.c_str(), journal_path.c_str()) != 0) {
+        ESP_LOGE(TAG, "Failed to compact TTL journal: %s", journal_path.c_str());
+        unlink(temp_path.c_str());
+        return;
+    }
+    _ttl_journal_records = _expiry.size();
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_ttl_load() {
+    std::string journal_path = _get_full_path(STORAGE_TTL_JOURNAL_FILE);
+    std::string temp_path = journal_path + ".tmp";
+    
+    FILE* f = fopen(journal_path.c_str(), "rb");
+    if (!f) {
+        f = fopen(temp_path.c_str(), "rb");
+        if (!f) {
+            return;
+        }
+        ESP_LOGW(TAG, "Recovering TTL journal from interrupted compaction");
+    }
+    
+    uint32_t magic = 0;
+    if (fread(&magic, sizeof(magic), 1, f) != 1 || magic != TTL_JOURNAL_MAGIC) {
+        ESP_LOGE(TAG, "TTL journal is corrupt, expiry times lost");
+        fclose(f);
+        return;
+    }
+    
+    // Replay in order; a record cut short by power loss ends the journal
+    uint32_t expires;
+    uint16_t key_length;
+    std::string key;
+    while (fread(&expires, sizeof(expires), 1, f) == 1 && fread(&key_length, sizeof(key_length), 1, f) == 1) {
+        key.resize(key_length);
+        if (fread(&key[0], 1, key_length, f) != key_length) {
+            break;
+        }
+        if (expires == 0) {
+            _expiry.erase(key);
+        } else {
+            _expiry[key] = expires;
+        }
+    }
+    fclose(f);
+    
+    for (auto it = _expiry.begin(); it != _expiry.end();) {
+        if (_stat_key(it->first, nullptr)) {
+            _expiry_heap.push({it->second, it->first});
+            ++it;
+        } else {
+            it = _expiry.erase(it);
+        }
+    }
+    
+    _ttl_compact();
+    unlink(temp_path.c_str());
+    
+    if constexpr (LogPolicy::debug) {
+        ESP_LOGI(TAG, "Loaded %u expiry times", (unsigned)_expiry.size());
+    }
+}
+
+STORAGE_ESP_TEMPLATE
+size_t STORAGE_ESP_CLASS::_reap_locked(size_t max_files) {
+    uint32_t now = (uint32_t)time(nullptr);
+    size_t reaped = 0;
+    
+    while (!_expiry_heap.empty() && reaped < max_files) {
+        expiry_entry top = _expiry_heap.top();
+        auto it = _expiry.find(top.second);
+        if (it == _expiry.end() || it->second != top.first) {
+            _expiry_heap.pop();  // Stale: rewritten, renamed or removed since
+            continue;
+        }
+        if (top.first > now) {
+            break;
+        }
+        
+        _expiry_heap.pop();
+        if (!_erase_file_locked(top.second)) {
+            // Gone already - stop tracking it
+            _ttl_forget_tree(top.second);
+        }
+        reaped++;
+    }
+    // Only stale entries at the top were dropped above
+    _ttl_prune_heap();
+    
+    if constexpr (LogPolicy::debug) {
+        if (reaped > 0) {
+            ESP_LOGI(TAG, "Reaped %u expired files", (unsigned)reaped);
+        }
+    }
+    return reaped;
+}
+
+STORAGE_ESP_TEMPLATE
+size_t STORAGE_ESP_CLASS::reap_expired(size_t max_files) {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return 0;
+    }
+
+    if (!_is_mounted) {
+        return 0;
+    }
+    
+    return _reap_locked(max_files);
+}
+
+STORAGE_ESP_TEMPLATE
+time_t STORAGE_ESP_CLASS::get_expiry(const std::string& key) {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return 0;
+    }
+
+    auto it = _expiry.find(_get_relative_dir(key));
+    return it != _expiry.end() ? (time_t)it->second : 0;
+}
+
+// ========== Garbage Collection ==========
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::_maintenance_locked(size_t reserve_bytes, bool yield_to_callers) {
+    if (!_is_mounted) {
+        return false;
+    }
+    
+    if (_storage_type != STORAGE_TYPE_SPIFFS) {
+        // LittleFS erases a block when it next allocates it; there is no backlog to clear
+        _gc_needed = false;
+        return true;
+    }
+    
+#ifdef STORAGE_SPIFFS_AVAILABLE
+    size_t total = 0, used = 0;
+    if (esp_spiffs_info(_partition_label.c_str(), &total, &used) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to get SPIFFS info for garbage collection");
+        return false;
+    }
+    
+    // Only space that is free can be made erased
+    size_t target = std::min(reserve_bytes, total > used ? total - used : 0);
+    _gc_needed = false;
+    if (target == 0) {
+        return true;
+    }
+    
+    int64_t start_us = esp_timer_get_time();
+    int64_t call_us = _last_call_us;
+    esp_err_t ret = ESP_OK;
+    
+    // esp_spiffs_gc() only does the work still missing for its target, so
+    // raising the target in steps splits one long pause into short ones
+    for (size_t step = std::min(target, (size_t)STORAGE_GC_STEP_BYTES); ; 
+         step = std::min(target, step + STORAGE_GC_STEP_BYTES)) {
+        ret = esp_spiffs_gc(_partition_label.c_str(), step);
+        if (ret != ESP_OK || step == target) {
+            break;
+        }
+        if (yield_to_callers && _last_call_us != call_us) {
+            // Someone is waiting for the lock; pick up again at the next idle period
+            _gc_needed = true;
+            break;
+        }
+    }
+    _gc_runs++;
+    
+    if constexpr (LogPolicy::debug) {
+        ESP_LOGI(TAG, "Garbage collection for %zu bytes took %lld us: %s", target,
+                 (long long)(esp_timer_get_time() - start_us), esp_err_to_name(ret));
+    }
+    
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Garbage collection could not free %zu bytes: %s", target, esp_err_to_name(ret));
+        return false;
+    }
+    return !_gc_needed;
+#else
+    return false;
+#endif
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::maintenance(size_t reserve_bytes) {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    return _maintenance_locked(reserve_bytes, false);
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::start_idle_gc() {
+    _idle_collect = true;
+    return _start_idle_task();
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::_start_idle_task() {
+    if constexpr (std::is_same_v<LockPolicy, storage_null_lock>) {
+        ESP_LOGE(TAG, "Idle garbage collection needs a locking policy");
+        return false;
+    }
+    
+    if (_gc_task_running) {
+        return true;
+    }
+    if (_mount_events == nullptr) {
+        return false;
+    }
+    
+    _gc_task_stop = false;
+    xEventGroupClearBits(_mount_events, GC_EXITED_BIT);
+    _gc_task_running = true;
+    
+    if (xTaskCreate(_idle_gc_task, "storage_gc", STORAGE_IDLE_GC_TASK_STACK_SIZE, this,
+                    STORAGE_IDLE_GC_TASK_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create idle garbage collection task");
+        _gc_task_running = false;
+        return false;
+    }
+    return true;
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::stop_idle_gc() {
+    if (!_gc_task_running) {
+        return;
+    }
+    
+    _gc_task_stop = true;
+    xEventGroupWaitBits(_mount_events, GC_EXITED_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
+    _gc_task_running = false;
+    _idle_collect = false;
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_idle_gc_task(void* arg) {
+    STORAGE_ESP_CLASS* self = static_cast<STORAGE_ESP_CLASS*>(arg);
+    int64_t delay_us = (int64_t)self->_config.idle_gc_delay_ms * 1000;
+    
+    while (!self->_gc_task_stop) {
+        vTaskDelay(pdMS_TO_TICKS(self->_config.idle_gc_poll_ms));
+        bool collect = self->_idle_collect && self->_gc_needed;
+        if (self->_gc_task_stop || (!collect && !self->_fsck_pending) ||
+            esp_timer_get_time() - self->_last_call_us < delay_us) {
+            continue;
+        }
+        
+        // Never wait: a held lock means a call is in progress, so not idle after all
+        lock_guard guard(self->_lock, 0);
+        if (!guard.locked()) {
+            continue;
+        }
+        if (self->_fsck_pending) {
+            self->_fsck_step_locked(self->_config.fsck_step_us);
+        } else {
+            self->_maintenance_locked(self->_config.gc_reserve_bytes, true);
+        }
+    }
+    
+    xEventGroupSetBits(self->_mount_events, GC_EXITED_BIT);
+    vTaskDelete(NULL);
+}
+
+// ========== Consistency Checker ==========
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_fsck_load() {
+    _fsck_walk.reset();
+    _fsck_pending = false;
+    _fsck_cursor.clear();
+    _fsck_passes = 0;
+    if (!_fsck_enabled()) {
+        return;
+    }
+    
+    // The cursor file exists from mount until a clean unmount, so finding it
+    // means the last session crashed or left a check unfinished
+    std::string cursor_path = _get_full_path(STORAGE_FSCK_CURSOR_FILE);
+    FILE* f = fopen(cursor_path.c_str(), "r");
+    if (f) {
+        char buffer[128];
+        size_t length;
+        while ((length = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+            _fsck_cursor.append(buffer, length);
+        }
+        fclose(f);
+        _fsck_pending = true;
+        
+        if constexpr (LogPolicy::debug) {
+            ESP_LOGI(TAG, "Consistency check pending%s%s", _fsck_cursor.empty() ? "" : ", resuming after ",
+                     _fsck_cursor.c_str());
+        }
+        return;
+    }
+    
+    _fsck_save();
+}
+
+STORAGE_ESP_TEMPLATE
+void STORAGE_ESP_CLASS::_fsck_save() {
+    std::string cursor_path = _get_full_path(STORAGE_FSCK_CURSOR_FILE);
+    FILE* f = STORAGE_FAULT_POINT("fsck.cursor") ? NULL : fopen(cursor_path.c_str(), "w");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to save consistency check cursor: %s", cursor_path.c_str());
+        return;
+    }
+    
+    bool ok = fwrite(_fsck_cursor.data(), 1, _fsck_cursor.length(), f) == _fsck_cursor.length();
+    ok = (fclose(f) == 0) && ok;
+    if (!ok) {
+        ESP_LOGE(TAG, "Failed to save consistency check cursor: %s", cursor_path.c_str());
+    }
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::_fsck_step_locked(uint32_t budget_us) {
+    if (!_fsck_pending) {
+        return true;
+    }
+    if (!_is_mounted) {
+        return false;
+    }
+    
+    _init_versioning();
+    int64_t start_us = esp_timer_get_time();
+    size_t examined = 0;
+    // A resumed walk can only find a cursor that names a file. Repairs delete
+    // artifacts the open walk may still return, so it is checked before saving.
+    auto cursor_exists = [this]() {
+        struct stat st;
+        return _fsck_cursor.empty() || stat(_get_full_path(_fsck_cursor).c_str(), &st) == 0;
+    };
+    
+    // Like the index rebuild, one walk is kept open across steps, so a pass
+    // reads each directory once. A repair removes or rewrites the artifact
+    // just returned or its siblings; the walk may or may not still return
+    // those, and repair_artifact() treats a missing one as consistent.
+    while (true) {
+        if (!_fsck_walk) {
+            if (_fsck_passes >= STORAGE_FSCK_MAX_PASSES) {
+                ESP_LOGW(TAG, "Consistency check still repairing after %u passes, giving up",
+                         (unsigned)_fsck_passes);
+                break;
+            }
+            _fsck_passes++;
+            
+            walk_options_t options = _walk_options("");
+            options.attributes = STORAGE_ATTR_NAME;
+            _fsck_walk.reset(new dir_walker(_base_path, options));
+            
+            // Resuming after a reboot or a reset walk: skip to the cursor and
+            // check on from there, then make one more full pass, since readdir
+            // order may have changed
+            _fsck_skipping = !_fsck_cursor.empty();
+            _fsck_rescan = _fsck_skipping;
+            _fsck_held = false;
+        }
+        
+        // At least one entry per step, however slow the walk is. A cursor
+        // that is gone is not saved; the step runs on to the next artifact
+        // and stops there instead.
+        if (examined > 0 && esp_timer_get_time() - start_us >= budget_us && cursor_exists()) {
+            _fsck_save();
+            return false;
+        }
+        
+        std::string path;
+        if (_fsck_held) {
+            path = _fsck_cursor;
+            _fsck_held = false;
+        } else {
+            file_info_t entry;
+            if (!_fsck_walk->next(entry)) {
+                _fsck_walk.reset();
+                // A pass that never found the cursor checked nothing. One that
+                // repaired something may have orphaned archives it had already
+                // passed (torn metadata is reset), so it is followed by another.
+                bool again = _fsck_skipping || _fsck_rescan;
+                _fsck_cursor.clear();
+                if (!again) {
+                    break;
+                }
+                continue;
+            }
+            examined++;
+            
+            size_t slash = entry.path.rfind('/');
+            if (!_is_version_artifact(slash == std::string::npos ? entry.path : entry.path.substr(slash + 1))) {
+                continue;
+            }
+            if (_fsck_skipping) {
+                // The cursor itself may not have been checked, so it is not skipped
+                if (entry.path != _fsck_cursor) {
+                    continue;
+                }
+                _fsck_skipping = false;
+            }
+            
+            _fsck_cursor = entry.path;
+            if (examined > 1 && esp_timer_get_time() - start_us >= budget_us) {
+                if (!cursor_exists()) {
+                    continue;  // Already repaired away, and a missing artifact is consistent
+                }
+                _fsck_held = true;
+                _fsck_save();
+                return false;
+            }
+            path = entry.path;
+        }
+        
+        uint32_t repaired = 0;
+        if constexpr (VersionPolicy::enabled) {
+            repaired = _versioning->repair_artifact(path);
+        }
+        if (repaired > 0) {
+            _fsck_repairs += repaired;
+            _fsck_rescan = true;
+        }
+    }
+    
+    // The session goes on, so the empty cursor stays as the crash marker
+    _fsck_walk.reset();
+    _fsck_pending = false;
+    _fsck_cursor.clear();
+    _fsck_passes = 0;
+    _fsck_save();
+    
+    if constexpr (LogPolicy::debug) {
+        ESP_LOGI(TAG, "Consistency check complete, %u repairs", (unsigned)_fsck_repairs);
+    }
+    return true;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::check_step(uint32_t budget_us) {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    return _fsck_step_locked(budget_us);
+}
+
+// ========== Advanced File Operations ==========
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::read_file_alloc(const std::string& key, uint8_t** data, size_t* size) {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    if (!_is_mounted || !data || !size || _ttl_expired(key)) {
+        return false;
+    }
+
+    // Called with the lock held - use the lock-free helpers
+    *size = 0;
+    if (!_stat_key(key, size) || *size == 0) {
+        return false;
+    }
+
+    *data = (uint8_t*)malloc(*size);
+    if (!*data) {
+        ESP_LOGE(TAG, "Failed to allocate memory for file: %s", key.c_str());
+        return false;
+    }
+
+    if (!_read_file_no_mutex(key, *data, *size)) {
+        free(*data);
+        *data = nullptr;
+        *size = 0;
+        return false;
+    }
+
+    _evict_touch(key, false);
+    return true;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::rename_file(const std::string& old_key, const std::string& new_key) {
+    if (_is_reserved_key(old_key) || _is_reserved_key(new_key)) {
+        return false;
+    }
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    if (!_is_mounted) {
+        return false;
+    }
+
+    std::string old_path = _get_file_path(old_key);
+    std::string new_path = _get_file_path(new_key);
+
+    // Under fan-out only files are relocated; a directory keeps its plain path
+    struct stat old_st, new_st;
+    bool old_exists = stat(old_path.c_str(), &old_st) == 0;
+    if (!old_exists && _key_fanout && stat(_get_full_path(old_key).c_str(), &old_st) == 0 &&
+        S_ISDIR(old_st.st_mode)) {
+        old_path = _get_full_path(old_key);
+        new_path = _get_full_path(new_key);
+        old_exists = true;
+    }
+
+    // A key renamed onto itself stays put; the bookkeeping below would
+    // subtract its size from the quotas without adding it back
+    if (_get_relative_dir(old_key) == _get_relative_dir(new_key)) {
+        return old_exists;
+    }
+
+    // Sizes for the quota counters, taken before the names change
+    bool quota_update = !_quotas.empty() && old_exists;
+    bool replaced = quota_update && stat(new_path.c_str(), &new_st) == 0 && !S_ISDIR(new_st.st_mode);
+
+    // The destination's parent - a bucket under fan-out - may not exist yet
+    size_t last_slash = new_path.rfind('/');
+    if (old_exists && last_slash != std::string::npos && last_slash > _base_path.length()) {
+        _create_directory_recursive(new_path.substr(0, last_slash));
+    }
+
+    if (!STORAGE_FAULT_POINT("rename") && rename(old_path.c_str(), new_path.c_str()) == 0) {
+        std::string old_dir, old_name, new_dir, new_name;
+        _split_key(old_key, old_dir, old_name);
+        _split_key(new_key, new_dir, new_name);
+        _dir_cache.invalidate(old_dir);
+        _dir_cache.invalidate(new_dir);
+        _dir_cache.invalidate_tree(old_dir.empty() ? old_name : old_dir + "/" + old_name);
+        _dir_cache.invalidate_tree(new_dir.empty() ? new_name : new_dir + "/" + new_name);
+#if STORAGE_ENABLE_METADATA_INDEX
+        _index.rename(_get_relative_dir(old_key), _get_relative_dir(new_key));
+        if (_index_rebuild) {
+            // The walk may already have passed the destination
+            _index_start_rebuild();
+        }
+#endif
+        _reservation_rename(_get_relative_dir(old_key), _get_relative_dir(new_key));
+        _evict_rename(_get_relative_dir(old_key), _get_relative_dir(new_key));
+        _ttl_rename(_get_relative_dir(old_key), _get_relative_dir(new_key));
+        if (quota_update && S_ISDIR(old_st.st_mode)) {
+            // Counting what moved would take a walk anyway; recount the quotas it touched
+            std::string old_dir_key = _get_relative_dir(old_key) + "/";
+            std::string new_dir_key = _get_relative_dir(new_key) + "/";
+            for (auto& entry : _quotas) {
+                if (_quota_matches(entry.first, old_dir_key) || _quota_matches(old_dir_key, entry.first) ||
+                    _quota_matches(entry.first, new_dir_key) || _quota_matches(new_dir_key, entry.first)) {
+                    _quota_recount(entry.first, entry.second);
+                }
+            }
+        } else if (quota_update) {
+            _quota_adjust(old_key, old_st.st_size, 0);
+            _quota_adjust(new_key, replaced ? new_st.st_size : 0, old_st.st_size);
+        }
+        if constexpr (LogPolicy::debug) {
+            ESP_LOGD(TAG, "Renamed file: %s -> %s", old_key.c_str(), new_key.c_str());
+        }
+        return true;
+    }
+
+    ESP_LOGE(TAG, "Failed to rename file: %s -> %s", old_key.c_str(), new_key.c_str());
+    return false;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::read_file_range(const std::string& key, size_t offset, void* data, size_t data_size) {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    if (_ttl_expired(key) || !_read_file_range_no_mutex(key, offset, data, data_size)) {
+        return false;
+    }
+    _evict_touch(key, false);
+    return true;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::write_file_range(const std::string& key, size_t offset, const void* data, size_t data_size) {
+    if (_is_reserved_key(key)) {
+        return false;
+    }
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    if (!_is_mounted || !data) {
+        return false;
+    }
+    
+    std::string full_path = _get_file_path(key);
+    
+    // An expired file is already gone as far as callers know; do not patch it back to life
+    if (_ttl_expired(key)) {
+        _erase_file_locked(key);
+    }
+    
+    struct stat st;
+    bool existed = stat(full_path.c_str(), &st) == 0;
+    
+    size_t old_size = existed ? st.st_size : 0;
+    size_t new_size = std::max(old_size, offset + data_size);
+    if (!_quota_admit(key, old_size, new_size)) {
+        return false;
+    }
+    // With versioning the bytes being overwritten go to a patch archive
+    size_t growth = new_size - old_size;
+    if (_versioning_enabled() && offset < old_size) {
+        growth += std::min(data_size, old_size - offset);
+    }
+    if (growth > 0) {
+        _evict_for(growth, key);
+    }
+    if (!_reservations.empty() && !_admit_growth(key, old_size, new_size)) {
+        return false;
+    }
+    
+    if (!existed) {
+        // Create parent directories if needed
+        size_t last_slash = full_path.rfind('/');
+        if (last_slash != std::string::npos && last_slash > _base_path.length()) {
+            _create_directory_recursive(full_path.substr(0, last_slash));
+        }
+    }
+    
+    if constexpr (VersionPolicy::enabled) {
+        if (_versioning_enabled()) {
+            _init_versioning();
+            if (!_versioning->on_before_write_range(key, offset, data_size)) {
+                return false;
+            }
+        }
+    }
+    
+    if (STORAGE_FAULT_POINT("range.open")) {
+        return false;
+    }
+    // "r+b" keeps existing contents; only the touched span is rewritten
+    FILE* f = fopen(full_path.c_str(), existed ? "r+b" : "w+b");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open file for update: %s", full_path.c_str());
+        return false;
+    }
+    
+    size_t bytes_written = 0;
+    if (STORAGE_FAULT_POINT("range.data")) {
+        // Power lost mid-write: half the span landed
+        if (fseek(f, offset, SEEK_SET) == 0) {
+            fwrite(data, 1, data_size / 2, f);
+        }
+        fclose(f);
+        return false;
+    }
+    if (fseek(f, offset, SEEK_SET) == 0) {
+        bytes_written = fwrite(data, 1, data_size, f);
+    }
+    fclose(f);
+    _stats.on_write(bytes_written);
+    
+    new_size = std::max(old_size, offset + bytes_written);
+    _cache_note_written(key, new_size);
+    _quota_adjust(key, old_size, new_size);
+    
+    if (bytes_written != data_size) {
+        ESP_LOGE(TAG, "Range write size mismatch: expected %zu, got %zu", data_size, bytes_written);
+        return false;
+    }
+    
+    if constexpr (VersionPolicy::enabled) {
+        if (_versioning) {
+            _versioning->on_after_write_range(key);
+        }
+    }
+    
+    _evict_touch(key, false);
+    
+    if constexpr (LogPolicy::debug) {
+        ESP_LOGD(TAG, "Wrote %zu bytes to %s at offset %zu", bytes_written, key.c_str(), offset);
+    }
+    return true;
+}
+
+STORAGE_ESP_TEMPLATE
+bool STORAGE_ESP_CLASS::verify_file_integrity(const std::string& key, size_t expected_size, uint32_t* checksum) {
+    _await_mount();
+
+    lock_guard guard(_lock, _config.lock_timeout);
+    if (!guard.locked()) {
+        return false;
+    }
+
+    if (!_is_mounted) {
+        return false;
+    }
+
+    // Check if file exists and has expected size
+    size_t actual_size = 0;
+    _stat_key(key, &actual_size);
+    if (actual_size != expected_size) {
+        ESP_LOGE(TAG, "File size mismatch for %s: expected %zu, actual %zu", 
+                 key.c_str(), expected_size, actual_size);
+        return false;
+    }
+
+    // If checksum verification is requested
+    if (checksum != nullptr) {
+        // Stream the file through a fixed buffer rather than loading it whole
+        FILE* f = fopen(_get_file_path(key).c_str(), "rb");
+        if (!f) {
+            ESP_LOGE(TAG, "Failed to open file for reading: %s", key.c_str());
+            return false;
+        }
+        
+        std::vector<uint8_t> buffer(_config.checksum_buffer_size);
+        uint32_t calculated_checksum = 0;
+        size_t bytes_read;
+        while ((bytes_read = fread(buffer.data(), 1, buffer.size(), f)) > 0) {
+            for (size_t i = 0; i < bytes_read; i++) {
+                calculated_checksum += buffer[i];
+            }
+        }
+        fclose(f);
+
+        if (calculated_checksum != *checksum) {
+            ESP_LOGE(TAG, "Checksum mismatch for %s: expected 0x%08X, calculated 0x%08X",
+                     key.c_str(), *checksum, calculated_checksum);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+#undef STORAGE_ESP_TEMPLATE
+#undef STORAGE_ESP_CLASS
@@ -0,0 +1,30 @@
+#include "storage_fault.h"
+
+uint32_t storage_fault_injector::_armed = 0;
+uint32_t storage_fault_injector::_boundaries = 0;
+bool storage_fault_injector::_powered_off = false;
+const char* storage_fault_injector::_fault_point = "";
+
+void storage_fault_injector::arm(uint32_t boundary) {
+    _armed = _boundaries + boundary;
+}
+
+void storage_fault_injector::reset() {
+    _armed = 0;
+    _boundaries = 0;
+    _powered_off = false;
+    _fault_point = "";
+}
+
+bool storage_fault_injector::hit(const char* point) {
+    if (_powered_off) {
+        return true;
+    }
+    
+    _boundaries++;
+    if (_armed != 0 && _boundaries >= _armed) {
+        _powered_off = true;
+        _fault_point = point;
+    }
+    return _powered_off;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "storage_config.h"
+#include <cstdint>
+
+/**
+ * @brief Simulated power loss at the driver's I/O boundaries
+ * 
+ * With STORAGE_ENABLE_FAULT_INJECTION, storage_esp passes every point where
+ * it changes the filesystem through STORAGE_FAULT_POINT(). Arming the injector
+ * with n cuts power at the nth boundary from then on: that boundary and every
+ * later one report a fault, so the operation stops where it is and nothing
+ * else reaches the filesystem - not even unmount's snapshots - until reset().
+ * Meant for host builds; the hooks compile to nothing when the switch is off.
+ * Global and not thread safe, like the power supply it stands in for.
+ */
+class storage_fault_injector {
+    public:
+        /**
+         * @brief Cut power at the given boundary (1-based), counted from now
+         */
+        static void arm(uint32_t boundary);
+
+        /**
+         * @brief Restore power, disarm and restart the boundary count
+         */
+        static void reset();
+
+        /**
+         * @brief Called at each boundary
+         * @param point Static name of the boundary, kept for the report
+         * @return true if power is off and the caller must stop
+         */
+        static bool hit(const char* point);
+
+        static bool is_powered_off() { return _powered_off; }
+        static uint32_t get_boundaries() { return _boundaries; }  // Passed since reset()
+        static const char* get_fault_point() { return _fault_point; }  // Where power was cut
+
+    private:
+        static uint32_t _armed;
+        static uint32_t _boundaries;
+        static bool _powered_off;
+        static const char* _fault_point;
+};
+
+#if STORAGE_ENABLE_FAULT_INJECTION
+#define STORAGE_FAULT_POINT(name) storage_fault_injector::hit(name)
+#else
+#define STORAGE_FAULT_POINT(name) false
+#endif
@@ -0,0 +1,201 @@
+#include "storage_fault_harness.h"
+#include "file_versioning.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <algorithm>
+
+static const char* TAG = "storage_fault";
+
+storage_fault_harness::storage_fault_harness(factory_t factory) : _factory(std::move(factory)) {
+}
+
+std::vector<storage_fault_result> storage_fault_harness::run(const storage_fault_scenario& scenario) {
+    std::vector<storage_fault_result> results;
+#if STORAGE_ENABLE_FAULT_INJECTION
+    // Dry run with power on to count the boundaries
+    std::unique_ptr<storage_esp> storage = _prepare(scenario);
+    if (!storage) {
+        return results;
+    }
+    scenario.operation(*storage);
+    uint32_t boundaries = storage_fault_injector::get_boundaries();
+    storage.reset();
+    
+    for (uint32_t boundary = 1; boundary <= boundaries; boundary++) {
+        storage = _prepare(scenario);
+        if (!storage) {
+            break;
+        }
+        
+        storage_fault_injector::arm(boundary);
+        scenario.operation(*storage);
+        storage_fault_result result;
+        result.boundary = boundary;
+        result.fault_point = storage_fault_injector::get_fault_point();
+        
+        // Destroyed with power still off: nothing the destructor tries to write lands
+        storage.reset();
+        storage_fault_injector::reset();
+        
+        int64_t start_us = esp_timer_get_time();
+        storage = _factory();
+        bool mounted = storage && storage->begin();
+        // Finish the consistency check here instead of in idle steps
+        while (mounted && storage->is_check_pending()) {
+            storage->check_step();
+        }
+        result.recovery_us = esp_timer_get_time() - start_us;
+        
+        if (!mounted) {
+            result.consistent = false;
+            result.problem = "remount failed";
+        } else {
+            result.consistent = _check(*storage, scenario, result.problem);
+        }
+        results.push_back(result);
+        storage.reset();
+    }
+#else
+    ESP_LOGE(TAG, "%s: fault injection is disabled (STORAGE_ENABLE_FAULT_INJECTION)", scenario.name.c_str());
+#endif
+    return results;
+}
+
+size_t storage_fault_harness::report(const std::string& scenario, const std::vector<storage_fault_result>& results) {
+    size_t failures = 0;
+    int64_t worst_us = 0;
+    for (const auto& result : results) {
+        if (!result.consistent) {
+            failures++;
+            ESP_LOGE(TAG, "%s: boundary %u (%s): %s, recovered in %lld us", scenario.c_str(),
+                     (unsigned)result.boundary, result.fault_point.c_str(), result.problem.c_str(),
+                     (long long)result.recovery_us);
+        } else {
+            ESP_LOGI(TAG, "%s: boundary %u (%s): consistent, recovered in %lld us", scenario.c_str(),
+                     (unsigned)result.boundary, result.fault_point.c_str(), (long long)result.recovery_us);
+        }
+        worst_us = std::max(worst_us, result.recovery_us);
+    }
+    
+    ESP_LOGI(TAG, "%s: %u/%u boundaries consistent, worst recovery %lld us", scenario.c_str(),
+             (unsigned)(results.size() - failures), (unsigned)results.size(), (long long)worst_us);
+    return failures;
+}
+
+// ========== Built-in Scenarios ==========
+
+static const size_t BUILTIN_FILE_SIZE = 256;
+
+/**
+ * @brief Check that key holds exactly one of the expected contents
+ * @param may_be_missing Also accept a key that does not exist
+ */
+static bool contents_match(storage_esp& storage, const std::string& key,
+                           const std::vector<std::vector<uint8_t>>& expected, std::string& problem,
+                           bool may_be_missing = false) {
+    if (may_be_missing && !storage.exists(key)) {
+        return true;
+    }
+    
+    std::vector<uint8_t> actual(storage.file_size(key));
+    if (actual.empty() || !storage.read_file(key, actual.data(), actual.size())) {
+        problem = key + ": missing or unreadable";
+        return false;
+    }
+    
+    for (const auto& contents : expected) {
+        if (actual == contents) {
+            return true;
+        }
+    }
+    problem = key + ": torn (" + std::to_string(actual.size()) + " bytes, neither old nor new)";
+    return false;
+}
+
+std::vector<storage_fault_scenario> storage_fault_harness::builtin_scenarios() {
+    std::vector<storage_fault_scenario> scenarios;
+    std::vector<uint8_t> first(BUILTIN_FILE_SIZE, 'A');
+    std::vector<uint8_t> second(BUILTIN_FILE_SIZE, 'B');
+    std::vector<uint8_t> third(BUILTIN_FILE_SIZE, 'C');
+    
+    // A new key: nothing to archive, so only the data and its metadata are written
+    storage_fault_scenario write;
+    write.name = "write_file";
+    write.keys = {"fault/blob"};
+    write.operation = [first](storage_esp& storage) {
+        storage.write_file("fault/blob", first.data(), first.size());
+    };
+    write.check = [first](storage_esp& storage, std::string& problem) {
+        return contents_match(storage, "fault/blob", {first}, problem, true);
+    };
+    scenarios.push_back(write);
+    
+    // The second write leaves version 2 current, so the operation archives it
+    storage_fault_scenario archive;
+    archive.name = "versioned_write_file";
+    archive.keys = {"fault/versioned"};
+    archive.setup = [first, second](storage_esp& storage) {
+        return storage.write_file("fault/versioned", first.data(), first.size()) &&
+               storage.write_file("fault/versioned", second.data(), second.size());
+    };
+    archive.operation = [third](storage_esp& storage) {
+        storage.write_file("fault/versioned", third.data(), third.size());
+    };
+    archive.check = [second, third](storage_esp& storage, std::string& problem) {
+        return contents_match(storage, "fault/versioned", {second, third}, problem);
+    };
+    scenarios.push_back(archive);
+    
+    std::vector<uint8_t> patched(first);
+    std::fill(patched.begin() + 16, patched.begin() + 20, 'B');
+    storage_fault_scenario range;
+    range.name = "write_file_range";
+    range.keys = {"fault/state"};
+    range.setup = [first](storage_esp& storage) {
+        return storage.write_file("fault/state", first.data(), first.size());
+    };
+    range.operation = [](storage_esp& storage) {
+        storage.write_file_range("fault/state", 16, "BBBB", 4);
+    };
+    range.check = [first, patched](storage_esp& storage, std::string& problem) {
+        return contents_match(storage, "fault/state", {first, patched}, problem);
+    };
+    scenarios.push_back(range);
+    
+    return scenarios;
+}
+
+// ========== Private Helpers ==========
+
+std::unique_ptr<storage_esp> storage_fault_harness::_prepare(const storage_fault_scenario& scenario) {
+    storage_fault_injector::reset();
+    
+    std::unique_ptr<storage_esp> storage = _factory();
+    if (!storage || !storage->begin() || !storage->format()) {
+        ESP_LOGE(TAG, "%s: could not mount and format", scenario.name.c_str());
+        return nullptr;
+    }
+    if (scenario.setup && !scenario.setup(*storage)) {
+        ESP_LOGE(TAG, "%s: setup failed", scenario.name.c_str());
+        return nullptr;
+    }
+    
+    // Only the operation's boundaries count
+    storage_fault_injector::reset();
+    return storage;
+}
+
+bool storage_fault_harness::_check(storage_esp& storage, const storage_fault_scenario& scenario, std::string& problem) {
+    file_versioning* versioning = storage.get_versioning();
+    for (const auto& key : scenario.keys) {
+        if (versioning && !versioning->check_metadata(key, &problem)) {
+            problem = key + ": " + problem;
+            return false;
+        }
+    }
+    
+    if (scenario.check && !scenario.check(storage, problem)) {
+        return false;
+    }
+    return true;
+}
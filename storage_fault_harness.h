@@ -0,0 +1,78 @@
+#pragma once
+
+#include "storage_esp.h"
+#include "storage_fault.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief One operation to interrupt, with the state it starts from
+ */
+struct storage_fault_scenario {
+    std::string name;
+    std::function<bool(storage_esp&)> setup;       // Runs with power on before every crash
+    std::function<void(storage_esp&)> operation;   // Interrupted at each boundary in turn
+    std::vector<std::string> keys;                 // Checked with file_versioning::check_metadata()
+
+    // Scenario-specific invariant after the remount; fills in the reason on failure
+    std::function<bool(storage_esp&, std::string&)> check;
+};
+
+/**
+ * @brief What survived power loss at one boundary
+ */
+struct storage_fault_result {
+    uint32_t boundary;          // 1-based, in the order the operation reaches them
+    std::string fault_point;    // STORAGE_FAULT_POINT() name where power was cut
+    bool consistent;
+    std::string problem;        // First invariant that failed
+    int64_t recovery_us;        // Remount plus the consistency check it leaves pending
+};
+
+/**
+ * @brief Crashes a scenario at every I/O boundary and checks the remounted state
+ * 
+ * A dry run counts the boundaries the operation passes. Then, for each one,
+ * the filesystem is formatted, the setup replayed and the operation run with
+ * power cut at that boundary; the instance is destroyed while still powered
+ * off, so unmount writes nothing, and a fresh instance mounts what was left
+ * and runs the pending consistency check to completion.
+ * Needs STORAGE_ENABLE_FAULT_INJECTION and formats the filesystem the factory
+ * points at, so it belongs in host builds and test partitions only.
+ */
+class storage_fault_harness {
+    public:
+        using factory_t = std::function<std::unique_ptr<storage_esp>()>;
+
+        explicit storage_fault_harness(factory_t factory);
+
+        /**
+         * @brief Run a scenario once per boundary
+         * @return One result per boundary; empty if the setup fails
+         */
+        std::vector<storage_fault_result> run(const storage_fault_scenario& scenario);
+
+        /**
+         * @brief Log one line per boundary and a summary
+         * @return Number of inconsistent results
+         */
+        static size_t report(const std::string& scenario, const std::vector<storage_fault_result>& results);
+
+        /**
+         * @brief Scenarios for the driver's own write paths
+         * 
+         * A new key written with write_file(), an overwrite that archives the
+         * previous version (so power is also cut between the archive's metadata
+         * and the data write), and an in-place write_file_range(). Each check
+         * accepts only the old or the new contents (or no file, for the new key).
+         */
+        static std::vector<storage_fault_scenario> builtin_scenarios();
+
+    private:
+        factory_t _factory;
+
+        std::unique_ptr<storage_esp> _prepare(const storage_fault_scenario& scenario);
+        bool _check(storage_esp& storage, const storage_fault_scenario& scenario, std::string& problem);
+};
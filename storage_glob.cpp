@@ -0,0 +1,163 @@
+#include "storage_glob.h"
+
+bool storage_glob::match(const std::string& pattern, const std::string& key) {
+    return _match_segments(_split(pattern), 0, _split(key), 0);
+}
+
+bool storage_glob::may_match_below(const std::string& pattern, const std::string& dir) {
+    return _match_below(_split(pattern), 0, _split(dir), 0);
+}
+
+std::string storage_glob::literal_prefix(const std::string& pattern) {
+    std::vector<std::string> segments = _split(pattern);
+    std::string prefix;
+    
+    // The last segment always names entries, never a directory to start from
+    for (size_t i = 0; i + 1 < segments.size(); i++) {
+        if (_has_wildcard(segments[i])) {
+            break;
+        }
+        prefix += segments[i] + "/";
+    }
+    return prefix;
+}
+
+// ========== Private Helper Methods ==========
+
+std::vector<std::string> storage_glob::_split(const std::string& path) {
+    std::vector<std::string> segments;
+    size_t start = 0;
+    
+    while (start <= path.length()) {
+        size_t end = path.find('/', start);
+        if (end == std::string::npos) {
+            end = path.length();
+        }
+        if (end > start) {
+            segments.push_back(path.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+    return segments;
+}
+
+bool storage_glob::_has_wildcard(const std::string& segment) {
+    return segment.find_first_of("*?[\\") != std::string::npos;
+}
+
+bool storage_glob::_match_class(const char*& pattern, char c) {
+    // pattern points just past '['
+    bool negate = (*pattern == '!' || *pattern == '^');
+    if (negate) {
+        pattern++;
+    }
+    
+    bool matched = false;
+    bool first = true;
+    while (*pattern != '\0' && (first || *pattern != ']')) {
+        char lo = *pattern++;
+        char hi = lo;
+        if (*pattern == '-' && pattern[1] != '\0' && pattern[1] != ']') {
+            hi = pattern[1];
+            pattern += 2;
+        }
+        if (c >= lo && c <= hi) {
+            matched = true;
+        }
+        first = false;
+    }
+    
+    if (*pattern == ']') {
+        pattern++;
+    }
+    return matched != negate;
+}
+
+bool storage_glob::_match_segment(const char* pattern, const char* text) {
+    // Iterative matcher with single-star backtracking
+    const char* star_pattern = nullptr;
+    const char* star_text = nullptr;
+    
+    while (*text != '\0') {
+        const char* p = pattern;
+        bool advanced = false;
+        
+        if (*p == '*') {
+            star_pattern = ++pattern;
+            star_text = text;
+            continue;
+        } else if (*p == '?') {
+            pattern++;
+            advanced = true;
+        } else if (*p == '[') {
+            p++;
+            if (_match_class(p, *text)) {
+                pattern = p;
+                advanced = true;
+            }
+        } else {
+            if (*p == '\\' && p[1] != '\0') {
+                p++;
+            }
+            if (*p == *text) {
+                pattern = p + 1;
+                advanced = true;
+            }
+        }
+        
+        if (advanced) {
+            text++;
+        } else if (star_pattern != nullptr) {
+            pattern = star_pattern;
+            text = ++star_text;
+        } else {
+            return false;
+        }
+    }
+    
+    while (*pattern == '*') {
+        pattern++;
+    }
+    return *pattern == '\0';
+}
+
+bool storage_glob::_match_segments(const std::vector<std::string>& pattern, size_t pi,
+                                   const std::vector<std::string>& path, size_t si) {
+    while (pi < pattern.size()) {
+        if (pattern[pi] == "**") {
+            // Try every possible number of swallowed segments
+            for (size_t skip = si; skip <= path.size(); skip++) {
+                if (_match_segments(pattern, pi + 1, path, skip)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        
+        if (si >= path.size() || !_match_segment(pattern[pi].c_str(), path[si].c_str())) {
+            return false;
+        }
+        pi++;
+        si++;
+    }
+    return si == path.size();
+}
+
+bool storage_glob::_match_below(const std::vector<std::string>& pattern, size_t pi,
+                                const std::vector<std::string>& dir, size_t di) {
+    while (pi < pattern.size()) {
+        if (pattern[pi] == "**") {
+            return true;
+        }
+        if (di == dir.size()) {
+            // Directory consumed with pattern left over for its children
+            return true;
+        }
+        if (!_match_segment(pattern[pi].c_str(), dir[di].c_str())) {
+            return false;
+        }
+        pi++;
+        di++;
+    }
+    return false;
+}
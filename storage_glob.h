@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Glob matching for storage keys
+ * 
+ * Supported syntax:
+ *  - '*'  any run of characters within one path segment
+ *  - '?'  any single character except '/'
+ *  - '**' as a whole segment, zero or more segments
+ *  - '[abc]', '[a-z]', '[!abc]' character classes
+ *  - '\' escapes the next character
+ */
+class storage_glob {
+    public:
+        /**
+         * @brief Whether key matches pattern in full
+         */
+        static bool match(const std::string& pattern, const std::string& key);
+
+        /**
+         * @brief Whether some key below directory dir could match pattern
+         * 
+         * Used to prune directories during a walk without opening them.
+         */
+        static bool may_match_below(const std::string& pattern, const std::string& dir);
+
+        /**
+         * @brief Leading directories of pattern that contain no wildcards
+         * @return Prefix ending in '/' ("logs/2024/" for "logs/2024/[ab]?.bin"), or ""
+         */
+        static std::string literal_prefix(const std::string& pattern);
+
+    private:
+        static std::vector<std::string> _split(const std::string& path);
+        static bool _has_wildcard(const std::string& segment);
+        static bool _match_segment(const char* pattern, const char* text);
+        static bool _match_class(const char*& pattern, char c);
+        static bool _match_segments(const std::vector<std::string>& pattern, size_t pi,
+                                    const std::vector<std::string>& path, size_t si);
+        static bool _match_below(const std::vector<std::string>& pattern, size_t pi,
+                                 const std::vector<std::string>& dir, size_t di);
+};
@@ -0,0 +1,338 @@
+#include "storage_mirror.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <cstring>
+#include <set>
+#include <algorithm>
+
+static const char* TAG = "storage_mirror";
+
+storage_mirror::storage_mirror(storage_interface* primary, storage_interface* secondary)
+    : _repairs(0), _checksum_failures(0), _mutex(nullptr), _job_ready(nullptr), _job_done(nullptr),
+      _task_running(false), _task_stop(false), _job_key(nullptr), _job_data(nullptr), _job_result(false) {
+    _replicas[0] = primary;
+    _replicas[1] = secondary;
+    _latency_us[0] = 0;
+    _latency_us[1] = 0;
+    
+    _mutex = xSemaphoreCreateMutex();
+    _job_ready = xSemaphoreCreateBinary();
+    _job_done = xSemaphoreCreateBinary();
+    if (_mutex == nullptr || _job_ready == nullptr || _job_done == nullptr) {
+        ESP_LOGE(TAG, "Failed to create mirror semaphores");
+    }
+}
+
+storage_mirror::~storage_mirror() {
+    _stop_writer();
+    
+    if (_mutex != nullptr) {
+        vSemaphoreDelete(_mutex);
+    }
+    if (_job_ready != nullptr) {
+        vSemaphoreDelete(_job_ready);
+    }
+    if (_job_done != nullptr) {
+        vSemaphoreDelete(_job_done);
+    }
+}
+
+// ========== Second Replica Writer ==========
+
+// Callers hold _mutex (except the destructor), so a write_file() waiting on
+// _job_done never sees the writer task stop underneath it
+
+void storage_mirror::_start_writer() {
+    if (_task_running || _job_ready == nullptr || _job_done == nullptr) {
+        return;
+    }
+    
+    _task_stop = false;
+    _task_running = true;
+    
+    // On the other core the two flash writes overlap instead of queueing
+    if (xTaskCreatePinnedToCore(_writer_task, "storage_mirror", STORAGE_MIRROR_TASK_STACK_SIZE, this,
+                                STORAGE_MIRROR_TASK_PRIORITY, NULL, STORAGE_MIRROR_TASK_CORE) != pdPASS) {
+        ESP_LOGW(TAG, "Failed to create writer task, replicas will be written in turn");
+        _task_running = false;
+    }
+}
+
+void storage_mirror::_stop_writer() {
+    if (!_task_running) {
+        return;
+    }
+    
+    _task_stop = true;
+    xSemaphoreGive(_job_ready);
+    xSemaphoreTake(_job_done, portMAX_DELAY);
+    _task_running = false;
+}
+
+void storage_mirror::_writer_task(void* arg) {
+    storage_mirror* self = static_cast<storage_mirror*>(arg);
+    
+    while (true) {
+        xSemaphoreTake(self->_job_ready, portMAX_DELAY);
+        if (self->_task_stop) {
+            break;
+        }
+        
+        self->_job_result = self->_replicas[1]->write_file(*self->_job_key, self->_job_data->data(),
+                                                          self->_job_data->size());
+        xSemaphoreGive(self->_job_done);
+    }
+    
+    xSemaphoreGive(self->_job_done);
+    vTaskDelete(NULL);
+}
+
+// ========== Public Interface Methods ==========
+
+bool storage_mirror::begin() {
+    bool ok[2] = {_replicas[0]->begin(), _replicas[1]->begin()};
+    if (!ok[0] || !ok[1]) {
+        ESP_LOGW(TAG, "Replica %d failed to start, running degraded", ok[0] ? 1 : 0);
+    }
+    
+    mutex_guard guard(_mutex);
+    _start_writer();
+    return ok[0] || ok[1];
+}
+
+bool storage_mirror::mount(bool format_on_fail) {
+    bool ok[2] = {_replicas[0]->mount(format_on_fail), _replicas[1]->mount(format_on_fail)};
+    if (!ok[0] || !ok[1]) {
+        ESP_LOGW(TAG, "Replica %d failed to mount, running degraded", ok[0] ? 1 : 0);
+    }
+    
+    mutex_guard guard(_mutex);
+    _start_writer();
+    return ok[0] || ok[1];
+}
+
+bool storage_mirror::unmount() {
+    mutex_guard guard(_mutex);
+    _stop_writer();
+    
+    bool ok = _replicas[0]->unmount();
+    return _replicas[1]->unmount() && ok;
+}
+
+bool storage_mirror::format() {
+    mutex_guard guard(_mutex);
+    
+    bool ok = _replicas[0]->format();
+    return _replicas[1]->format() && ok;
+}
+
+bool storage_mirror::get_is_mounted() const {
+    return _replicas[0]->get_is_mounted() || _replicas[1]->get_is_mounted();
+}
+
+bool storage_mirror::read_file(const std::string& key, void* data, size_t data_size) {
+    if (!data) {
+        return false;
+    }
+    
+    int first = (_latency_us[1] < _latency_us[0]) ? 1 : 0;
+    int second = first ^ 1;
+    std::vector<uint8_t> payload;
+    
+    if (_read_replica(first, key, payload)) {
+        _copy_out(payload, data, data_size);
+        return !payload.empty() || data_size == 0;
+    }
+    
+    if (_read_replica(second, key, payload)) {
+        mutex_guard guard(_mutex);
+        _repair(first, key);
+        _copy_out(payload, data, data_size);
+        return !payload.empty() || data_size == 0;
+    }
+    
+    // Both copies bad may just mean a write is in flight - retry with writes held off
+    mutex_guard guard(_mutex);
+    for (int i = 0; i < 2; i++) {
+        if (_read_replica(i, key, payload)) {
+            _repair(i ^ 1, key);
+            _copy_out(payload, data, data_size);
+            return !payload.empty() || data_size == 0;
+        }
+    }
+    
+    ESP_LOGE(TAG, "No valid replica of %s", key.c_str());
+    return false;
+}
+
+bool storage_mirror::write_file(const std::string& key, const void* data, size_t data_size) {
+    if (!data) {
+        return false;
+    }
+    
+    mutex_guard guard(_mutex);
+    
+    std::vector<uint8_t> buffer((const uint8_t*)data, (const uint8_t*)data + data_size);
+    mirror_trailer trailer = {TRAILER_MAGIC, _update_crc32(0, data, data_size)};
+    buffer.insert(buffer.end(), (const uint8_t*)&trailer, (const uint8_t*)&trailer + sizeof(trailer));
+    
+    bool ok[2];
+    if (_task_running) {
+        _job_key = &key;
+        _job_data = &buffer;
+        xSemaphoreGive(_job_ready);
+        ok[0] = _replicas[0]->write_file(key, buffer.data(), buffer.size());
+        xSemaphoreTake(_job_done, portMAX_DELAY);
+        ok[1] = _job_result;
+    } else {
+        ok[0] = _replicas[0]->write_file(key, buffer.data(), buffer.size());
+        ok[1] = _replicas[1]->write_file(key, buffer.data(), buffer.size());
+    }
+    
+    for (int i = 0; i < 2; i++) {
+        if (!ok[i] && ok[i ^ 1]) {
+            // An old copy would still pass its checksum - remove it so reads
+            // fall through to the new data and repair this replica
+            ESP_LOGW(TAG, "Replica %d write failed for %s", i, key.c_str());
+            _replicas[i]->erase_file(key);
+        }
+    }
+    
+    return ok[0] || ok[1];
+}
+
+bool storage_mirror::erase_file(const std::string& key) {
+    mutex_guard guard(_mutex);
+    
+    bool ok = _replicas[0]->erase_file(key);
+    return _replicas[1]->erase_file(key) || ok;
+}
+
+size_t storage_mirror::file_size(const std::string& key) {
+    for (int i = 0; i < 2; i++) {
+        size_t size = _replicas[i]->file_size(key);
+        if (size >= sizeof(mirror_trailer)) {
+            return size - sizeof(mirror_trailer);
+        }
+    }
+    return 0;
+}
+
+bool storage_mirror::exists(const std::string& key) {
+    return _replicas[0]->exists(key) || _replicas[1]->exists(key);
+}
+
+size_t storage_mirror::total_size() {
+    // Every file lives on both, so the smaller replica bounds the capacity
+    return std::min(_replicas[0]->total_size(), _replicas[1]->total_size());
+}
+
+size_t storage_mirror::used_size() {
+    return std::max(_replicas[0]->used_size(), _replicas[1]->used_size());
+}
+
+bool storage_mirror::list_all_files(std::vector<file_info_t>& files) {
+    std::set<std::string> seen;
+    std::vector<file_info_t> replica_files;
+    bool any = false;
+    
+    for (int i = 0; i < 2; i++) {
+        replica_files.clear();
+        if (!_replicas[i]->list_all_files(replica_files)) {
+            continue;
+        }
+        any = true;
+        
+        for (auto& info : replica_files) {
+            if (!seen.insert(info.path).second) {
+                continue;
+            }
+            if (!info.is_directory && info.size >= sizeof(mirror_trailer)) {
+                info.size -= sizeof(mirror_trailer);
+            }
+            files.push_back(info);
+        }
+    }
+    return any;
+}
+
+// ========== Private Helper Methods ==========
+
+bool storage_mirror::_read_replica(int index, const std::string& key, std::vector<uint8_t>& payload) {
+    storage_interface* replica = _replicas[index];
+    if (!replica->get_is_mounted()) {
+        return false;
+    }
+    
+    int64_t start_us = esp_timer_get_time();
+    
+    size_t size = replica->file_size(key);
+    if (size < sizeof(mirror_trailer)) {
+        return false;
+    }
+    
+    payload.resize(size);
+    if (!replica->read_file(key, payload.data(), size)) {
+        return false;
+    }
+    
+    mirror_trailer trailer;
+    size_t payload_size = size - sizeof(trailer);
+    memcpy(&trailer, payload.data() + payload_size, sizeof(trailer));
+    payload.resize(payload_size);
+    
+    if (trailer.magic != TRAILER_MAGIC || trailer.crc != _update_crc32(0, payload.data(), payload_size)) {
+        ESP_LOGW(TAG, "Checksum mismatch on replica %d for %s", index, key.c_str());
+        _checksum_failures++;
+        return false;
+    }
+    
+    // Only good reads feed the average, so a missing copy does not look fast
+    uint32_t sample = (uint32_t)(esp_timer_get_time() - start_us);
+    uint32_t average = _latency_us[index];
+    _latency_us[index] = average == 0 ? sample : average - average / 8 + sample / 8;
+    return true;
+}
+
+void storage_mirror::_repair(int bad, const std::string& key) {
+    // Called with _mutex held. Re-check both copies: a write that finished
+    // after the unlocked read may already have fixed the bad one.
+    std::vector<uint8_t> payload;
+    if (_read_replica(bad, key, payload) || !_read_replica(bad ^ 1, key, payload)) {
+        return;
+    }
+    
+    mirror_trailer trailer = {TRAILER_MAGIC, _update_crc32(0, payload.data(), payload.size())};
+    payload.insert(payload.end(), (const uint8_t*)&trailer, (const uint8_t*)&trailer + sizeof(trailer));
+    
+    if (_replicas[bad]->write_file(key, payload.data(), payload.size())) {
+        _repairs++;
+        ESP_LOGW(TAG, "Repaired replica %d of %s", bad, key.c_str());
+    } else {
+        ESP_LOGE(TAG, "Failed to repair replica %d of %s", bad, key.c_str());
+    }
+}
+
+void storage_mirror::_copy_out(const std::vector<uint8_t>& payload, void* data, size_t data_size) {
+    // Same contract as storage_esp: a short file fills part of the buffer
+    memcpy(data, payload.data(), std::min(data_size, payload.size()));
+}
+
+uint32_t storage_mirror::_update_crc32(uint32_t crc, const void* data, size_t length) {
+    // CRC32 polynomial (IEEE 802.3), same as file_versioning
+    const uint8_t* bytes = (const uint8_t*)data;
+    crc = crc ^ 0xFFFFFFFF;
+    
+    for (size_t i = 0; i < length; i++) {
+        crc ^= bytes[i];
+        for (int j = 0; j < 8; j++) {
+            if (crc & 1) {
+                crc = (crc >> 1) ^ 0xEDB88320;
+            } else {
+                crc = crc >> 1;
+            }
+        }
+    }
+    
+    return crc ^ 0xFFFFFFFF;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "interface/storage_interface.h"
+#include "storage_config.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief storage_interface keeping a checksummed copy of every file on two backends
+ *
+ * Each replica stores the data followed by a small trailer holding a CRC32.
+ * Writes go to both replicas at once: the caller writes the first while a
+ * worker task, pinned to the other core, writes the second. Reads go to the
+ * replica with the lower average latency and fall back to the other one when
+ * the copy is missing or fails its checksum; the bad copy is then repaired
+ * from the good one. Keeps working with one replica if the other fails.
+ */
+class storage_mirror : public storage_interface
+{
+    public:
+        storage_mirror(storage_interface* primary, storage_interface* secondary);
+        ~storage_mirror();
+
+        // ===== storage_interface implementation =====
+        bool begin() override;
+        bool read_file(const std::string& key, void* data, size_t data_size) override;
+        bool write_file(const std::string& key, const void* data, size_t data_size) override;
+        bool erase_file(const std::string& key) override;
+        size_t file_size(const std::string& key) override;
+        bool exists(const std::string& key) override;
+        size_t total_size() override;
+        size_t used_size() override;
+        bool mount(bool format_on_fail = STORAGE_FORMAT_IF_MOUNT_FAILS) override;
+        bool unmount() override;
+        bool format() override;
+        bool list_all_files(std::vector<file_info_t>& files) override;
+        bool get_is_mounted() const override;
+
+        // ===== Getters =====
+        storage_interface* get_replica(int index) const { return _replicas[index & 1]; }
+        uint32_t get_read_latency_us(int index) const { return _latency_us[index & 1]; }
+        uint32_t get_repairs() const { return _repairs; }
+        uint32_t get_checksum_failures() const { return _checksum_failures; }
+
+    private:
+        struct mirror_trailer {
+            uint32_t magic;
+            uint32_t crc;
+        };
+        static const uint32_t TRAILER_MAGIC = 0x5252494d;  // "MIRR"
+
+        storage_interface* _replicas[2];
+        std::atomic<uint32_t> _latency_us[2];  // EWMA of read latency
+        std::atomic<uint32_t> _repairs;
+        std::atomic<uint32_t> _checksum_failures;
+
+        // Serializes writes and repairs so a repair never reverts a newer write
+        SemaphoreHandle_t _mutex;
+
+        // Second-replica writer
+        SemaphoreHandle_t _job_ready;
+        SemaphoreHandle_t _job_done;
+        bool _task_running;
+        bool _task_stop;
+        const std::string* _job_key;
+        const std::vector<uint8_t>* _job_data;
+        bool _job_result;
+        static void _writer_task(void* arg);
+        void _start_writer();
+        void _stop_writer();
+
+        class mutex_guard {
+        public:
+            explicit mutex_guard(SemaphoreHandle_t& mutex) : m_mutex(mutex) {
+                xSemaphoreTake(m_mutex, STORAGE_MUTEX_TIMEOUT_MS);
+            }
+            ~mutex_guard() {
+                xSemaphoreGive(m_mutex);
+            }
+        private:
+            SemaphoreHandle_t& m_mutex;
+        };
+
+        // ===== Internal helpers =====
+        bool _read_replica(int index, const std::string& key, std::vector<uint8_t>& payload);
+        void _repair(int bad, const std::string& key);
+        static void _copy_out(const std::vector<uint8_t>& payload, void* data, size_t data_size);
+        static uint32_t _update_crc32(uint32_t crc, const void* data, size_t length);
+};
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "storage_config.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+/**
+ * @brief Feature policies for basic_storage_esp
+ *
+ * Each feature is a template parameter, so an instance only pays for what it
+ * uses and the code for a null policy compiles away entirely. The defaults
+ * follow the STORAGE_ENABLE_* switches in storage_config.h.
+ */
+
+// ===== Lock policies =====
+
+/**
+ * @brief Serializes calls with a FreeRTOS mutex
+ */
+class storage_mutex_lock {
+    public:
+        storage_mutex_lock() {
+            _mutex = xSemaphoreCreateMutex();
+            if (_mutex == nullptr) {
+                ESP_LOGE("storage_esp", "Failed to create storage mutex");
+            }
+        }
+        ~storage_mutex_lock() {
+            if (_mutex != nullptr) {
+                vSemaphoreDelete(_mutex);
+            }
+        }
+        storage_mutex_lock(const storage_mutex_lock&) = delete;
+        storage_mutex_lock& operator=(const storage_mutex_lock&) = delete;
+
+        class guard {
+            public:
+                guard(storage_mutex_lock& lock, TickType_t timeout) : m_mutex(lock._mutex) {
+                    m_locked = xSemaphoreTake(m_mutex, timeout) == pdTRUE;
+                    // A zero timeout is a deliberate try-lock, not a failure
+                    if (!m_locked && timeout != 0) {
+                        ESP_LOGE("storage_esp", "Timed out waiting for storage lock");
+                    }
+                }
+                ~guard() {
+                    if (m_locked) {
+                        xSemaphoreGive(m_mutex);
+                    }
+                }
+                bool locked() const { return m_locked; }
+            private:
+                SemaphoreHandle_t m_mutex;
+                bool m_locked;
+        };
+
+    private:
+        SemaphoreHandle_t _mutex;
+};
+
+/**
+ * @brief No locking, for instances only ever used from one task
+ */
+class storage_null_lock {
+    public:
+        class guard {
+            public:
+                guard(storage_null_lock&, TickType_t) {}
+                constexpr bool locked() const { return true; }
+        };
+};
+
+// ===== Versioning policies =====
+
+struct storage_versioning_on {
+    static constexpr bool enabled = true;
+};
+
+struct storage_versioning_off {
+    static constexpr bool enabled = false;
+};
+
+// ===== Stats policies =====
+
+/**
+ * @brief Counts file operations and bytes moved, and times write_file()
+ *
+ * Write latencies go into power-of-two buckets, so percentiles are upper
+ * bounds within a factor of two - enough to see a garbage collection pause.
+ */
+class storage_io_stats {
+    public:
+        static constexpr bool timed = true;
+
+        void on_read(size_t bytes) { _reads++; _bytes_read += bytes; }
+        void on_write(size_t bytes) { _writes++; _bytes_written += bytes; }
+        void on_erase() { _erases++; }
+        void on_write_latency(int64_t latency_us) {
+            size_t bucket = 0;
+            while (bucket < LATENCY_BUCKETS - 1 && latency_us >= (int64_t)1 << bucket) {
+                bucket++;
+            }
+            _write_latency[bucket]++;
+        }
+
+        uint32_t get_reads() const { return _reads; }
+        uint32_t get_writes() const { return _writes; }
+        uint32_t get_erases() const { return _erases; }
+        uint64_t get_bytes_read() const { return _bytes_read; }
+        uint64_t get_bytes_written() const { return _bytes_written; }
+
+        /**
+         * @brief Write latency below which the given share of write_file() calls finished
+         * @param percentile 0-100, e.g. 99 for p99
+         * @return Upper bound in microseconds, 0 before the first write
+         */
+        uint32_t get_write_latency_us(uint32_t percentile) const {
+            uint64_t total = 0;
+            for (const auto& count : _write_latency) {
+                total += count;
+            }
+            uint64_t needed = (total * percentile + 99) / 100;
+            uint64_t seen = 0;
+            for (size_t bucket = 0; bucket < LATENCY_BUCKETS && total > 0; bucket++) {
+                seen += _write_latency[bucket];
+                if (seen >= needed) {
+                    return bucket == 0 ? 1 : (uint32_t)1 << bucket;
+                }
+            }
+            return 0;
+        }
+
+        void reset() {
+            _reads = 0; _writes = 0; _erases = 0; _bytes_read = 0; _bytes_written = 0;
+            for (auto& count : _write_latency) {
+                count = 0;
+            }
+        }
+
+    private:
+        std::atomic<uint32_t> _reads{0};
+        std::atomic<uint32_t> _writes{0};
+        std::atomic<uint32_t> _erases{0};
+        std::atomic<uint64_t> _bytes_read{0};
+        std::atomic<uint64_t> _bytes_written{0};
+
+        // Bucket n counts latencies in [2^(n-1), 2^n) us; the last one is open-ended
+        static constexpr size_t LATENCY_BUCKETS = 24;
+        std::atomic<uint32_t> _write_latency[LATENCY_BUCKETS] = {};
+};
+
+class storage_null_stats {
+    public:
+        static constexpr bool timed = false;
+
+        void on_read(size_t) {}
+        void on_write(size_t) {}
+        void on_erase() {}
+        void on_write_latency(int64_t) {}
+};
+
+// ===== Log policies =====
+
+struct storage_debug_log {
+    static constexpr bool debug = true;
+};
+
+struct storage_quiet_log {
+    static constexpr bool debug = false;
+};
+
+// ===== Defaults from storage_config.h =====
+
+using storage_default_lock = std::conditional_t<STORAGE_ENABLE_MUTEX_PROTECTION,
+                                                storage_mutex_lock, storage_null_lock>;
+using storage_default_versioning = std::conditional_t<STORAGE_ENABLE_VERSIONING,
+                                                      storage_versioning_on, storage_versioning_off>;
+using storage_default_stats = std::conditional_t<STORAGE_ENABLE_IO_STATS,
+                                                 storage_io_stats, storage_null_stats>;
+using storage_default_log = std::conditional_t<STORAGE_ENABLE_DEBUG_LOGGING,
+                                               storage_debug_log, storage_quiet_log>;
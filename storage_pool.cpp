@@ -0,0 +1,190 @@
+#include "storage_pool.h"
+#include "key_fanout.h"
+#include "esp_log.h"
+#include <algorithm>
+
+static const char* TAG = "storage_pool";
+
+storage_pool::storage_pool() {
+}
+
+// ========== Configuration ==========
+
+int storage_pool::add_member(storage_interface* member, bool hash_target) {
+    if (member == nullptr) {
+        ESP_LOGE(TAG, "Cannot add null member");
+        return -1;
+    }
+    
+    int index = (int)_members.size();
+    _members.push_back(member);
+    if (hash_target) {
+        _hash_members.push_back(index);
+    }
+    return index;
+}
+
+bool storage_pool::add_route(const std::string& prefix, int member) {
+    if (member < 0 || member >= (int)_members.size()) {
+        ESP_LOGE(TAG, "Route %s targets unknown member %d", prefix.c_str(), member);
+        return false;
+    }
+    
+    std::string normalized = _normalize_key(prefix);
+    for (auto& rule : _routes) {
+        if (rule.prefix == normalized) {
+            rule.member = member;
+            return true;
+        }
+    }
+    
+    // Keep the longest prefix first so the first match is the most specific
+    auto position = std::find_if(_routes.begin(), _routes.end(), [&](const route_rule& rule) {
+        return rule.prefix.length() < normalized.length();
+    });
+    _routes.insert(position, {normalized, member});
+    return true;
+}
+
+// ========== Routing ==========
+
+std::string storage_pool::_normalize_key(const std::string& key) {
+    size_t start = key.find_first_not_of('/');
+    return start == std::string::npos ? "" : key.substr(start);
+}
+
+int storage_pool::route_index(const std::string& key) const {
+    std::string normalized = _normalize_key(key);
+    
+    for (const auto& rule : _routes) {
+        if (normalized.compare(0, rule.prefix.length(), rule.prefix) == 0) {
+            return rule.member;
+        }
+    }
+    
+    if (!_hash_members.empty()) {
+        uint32_t hash = key_fanout::hash(normalized.data(), normalized.length());
+        return _hash_members[hash % _hash_members.size()];
+    }
+    
+    // No hash targets - everything unrouted lands on the first member
+    return _members.empty() ? -1 : 0;
+}
+
+storage_interface* storage_pool::route(const std::string& key) const {
+    int index = route_index(key);
+    return index < 0 ? nullptr : _members[index];
+}
+
+// ========== Public Interface Methods ==========
+
+bool storage_pool::begin() {
+    if (_members.empty()) {
+        ESP_LOGE(TAG, "Storage pool has no members");
+        return false;
+    }
+    
+    bool ok = true;
+    for (auto* member : _members) {
+        ok = member->begin() && ok;
+    }
+    return ok;
+}
+
+bool storage_pool::mount(bool format_on_fail) {
+    if (_members.empty()) {
+        ESP_LOGE(TAG, "Storage pool has no members");
+        return false;
+    }
+    
+    bool ok = true;
+    for (auto* member : _members) {
+        ok = member->mount(format_on_fail) && ok;
+    }
+    return ok;
+}
+
+bool storage_pool::unmount() {
+    bool ok = true;
+    for (auto* member : _members) {
+        ok = member->unmount() && ok;
+    }
+    return ok;
+}
+
+bool storage_pool::format() {
+    bool ok = true;
+    for (auto* member : _members) {
+        ok = member->format() && ok;
+    }
+    return ok;
+}
+
+bool storage_pool::get_is_mounted() const {
+    if (_members.empty()) {
+        return false;
+    }
+    for (auto* member : _members) {
+        if (!member->get_is_mounted()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool storage_pool::read_file(const std::string& key, void* data, size_t data_size) {
+    storage_interface* member = route(key);
+    return member && member->read_file(key, data, data_size);
+}
+
+bool storage_pool::write_file(const std::string& key, const void* data, size_t data_size) {
+    storage_interface* member = route(key);
+    return member && member->write_file(key, data, data_size);
+}
+
+bool storage_pool::erase_file(const std::string& key) {
+    storage_interface* member = route(key);
+    return member && member->erase_file(key);
+}
+
+size_t storage_pool::file_size(const std::string& key) {
+    storage_interface* member = route(key);
+    return member ? member->file_size(key) : 0;
+}
+
+bool storage_pool::exists(const std::string& key) {
+    storage_interface* member = route(key);
+    return member && member->exists(key);
+}
+
+size_t storage_pool::total_size() {
+    size_t total = 0;
+    for (auto* member : _members) {
+        total += member->total_size();
+    }
+    return total;
+}
+
+size_t storage_pool::used_size() {
+    size_t used = 0;
+    for (auto* member : _members) {
+        used += member->used_size();
+    }
+    return used;
+}
+
+bool storage_pool::list_all_files(std::vector<file_info_t>& files) {
+    files.clear();
+    
+    bool ok = true;
+    std::vector<file_info_t> member_files;
+    for (auto* member : _members) {
+        member_files.clear();
+        if (!member->list_all_files(member_files)) {
+            ok = false;
+            continue;
+        }
+        files.insert(files.end(), member_files.begin(), member_files.end());
+    }
+    return ok;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "interface/storage_interface.h"
+#include "storage_config.h"
+#include <string>
+#include <vector>
+
+/**
+ * @brief storage_interface over several backends, routing each key to one of them
+ * 
+ * A key goes to the member of the longest matching prefix route, or, when no
+ * route matches, to a member picked by hashing the key over the hash targets.
+ * The pool holds no lock of its own: every call goes straight to one member,
+ * so members on independent partitions serve I/O concurrently, each under
+ * its own mutex. Members and routes must be configured before the pool is
+ * shared between tasks and must not change afterwards - doing so would route
+ * existing keys elsewhere.
+ */
+class storage_pool : public storage_interface
+{
+    public:
+        storage_pool();
+
+        // ===== Configuration =====
+        /**
+         * @brief Add a backend; the pool does not take ownership
+         * @param hash_target Whether keys without a route may be hashed onto it
+         * @return Member index for add_route(), or -1 on failure
+         */
+        int add_member(storage_interface* member, bool hash_target = true);
+
+        /**
+         * @brief Send every key starting with prefix to one member
+         */
+        bool add_route(const std::string& prefix, int member);
+
+        // ===== storage_interface implementation =====
+        bool begin() override;
+        bool read_file(const std::string& key, void* data, size_t data_size) override;
+        bool write_file(const std::string& key, const void* data, size_t data_size) override;
+        bool erase_file(const std::string& key) override;
+        size_t file_size(const std::string& key) override;
+        bool exists(const std::string& key) override;
+        size_t total_size() override;
+        size_t used_size() override;
+        bool mount(bool format_on_fail = STORAGE_FORMAT_IF_MOUNT_FAILS) override;
+        bool unmount() override;
+        bool format() override;
+        bool list_all_files(std::vector<file_info_t>& files) override;
+        bool get_is_mounted() const override;
+
+        // ===== Routing =====
+        /**
+         * @brief Member index a key is routed to, or -1 if the pool is empty
+         */
+        int route_index(const std::string& key) const;
+        storage_interface* route(const std::string& key) const;
+
+        // ===== Getters =====
+        size_t get_member_count() const { return _members.size(); }
+        storage_interface* get_member(size_t index) const {
+            return index < _members.size() ? _members[index] : nullptr;
+        }
+
+    private:
+        struct route_rule {
+            std::string prefix;
+            int member;
+        };
+
+        std::vector<storage_interface*> _members;
+        std::vector<int> _hash_members;
+        std::vector<route_rule> _routes;  // Longest prefix first
+
+        static std::string _normalize_key(const std::string& key);
+};
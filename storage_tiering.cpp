@@ -0,0 +1,467 @@
+#include "storage_tiering.h"
+#include "esp_log.h"
+#include <algorithm>
+#include <unordered_set>
+
+static const char* TAG = "storage_tiering";
+
+storage_tiering::storage_tiering()
+    : _next_generation(1), _promotions(0), _demotions(0), _aborted(0),
+      _mutex(nullptr), _task_events(nullptr), _task_running(false), _task_stop(false),
+      _interval_ms(STORAGE_TIER_MIGRATE_INTERVAL_MS) {
+    _mutex = xSemaphoreCreateMutex();
+    if (_mutex == nullptr) {
+        ESP_LOGE(TAG, "Failed to create tiering mutex");
+    }
+    
+    _task_events = xEventGroupCreate();
+    if (_task_events == nullptr) {
+        ESP_LOGE(TAG, "Failed to create migration event group");
+    }
+}
+
+storage_tiering::~storage_tiering() {
+    stop_migration();
+    
+    if (_mutex != nullptr) {
+        vSemaphoreDelete(_mutex);
+    }
+    if (_task_events != nullptr) {
+        vEventGroupDelete(_task_events);
+    }
+}
+
+// ========== Configuration ==========
+
+int storage_tiering::add_tier(storage_interface* tier) {
+    if (tier == nullptr) {
+        ESP_LOGE(TAG, "Cannot add null tier");
+        return -1;
+    }
+    _tiers.push_back(tier);
+    return (int)_tiers.size() - 1;
+}
+
+// ========== Key Location ==========
+
+int storage_tiering::_locate(const std::string& key) {
+    {
+        mutex_guard guard(_mutex);
+        auto it = _keys.find(key);
+        if (it != _keys.end()) {
+            return it->second.erased ? -1 : it->second.tier;
+        }
+    }
+    
+    // Unknown key (first access since boot) - probe fastest first. A key in
+    // flight always has an entry, so this never finds a migration's copy
+    for (size_t i = 0; i < _tiers.size(); i++) {
+        if (!_tiers[i]->exists(key)) {
+            continue;
+        }
+        
+        size_t size = _tiers[i]->file_size(key);
+        mutex_guard guard(_mutex);
+        // Another task may have located or written the key meanwhile
+        auto result = _keys.emplace(key, key_state{(int)i, size, 0, _next_generation++, 0, false, false});
+        return result.first->second.tier;
+    }
+    
+    return -1;
+}
+
+int storage_tiering::get_tier_of(const std::string& key) {
+    return _locate(key);
+}
+
+// ========== Public Interface Methods ==========
+
+bool storage_tiering::begin() {
+    if (_tiers.empty()) {
+        ESP_LOGE(TAG, "Tiered storage has no tiers");
+        return false;
+    }
+    
+    bool ok = true;
+    for (auto* tier : _tiers) {
+        ok = tier->begin() && ok;
+    }
+    return ok;
+}
+
+bool storage_tiering::mount(bool format_on_fail) {
+    if (_tiers.empty()) {
+        ESP_LOGE(TAG, "Tiered storage has no tiers");
+        return false;
+    }
+    
+    bool ok = true;
+    for (auto* tier : _tiers) {
+        ok = tier->mount(format_on_fail) && ok;
+    }
+    return ok;
+}
+
+bool storage_tiering::unmount() {
+    stop_migration();
+    
+    bool ok = true;
+    for (auto* tier : _tiers) {
+        ok = tier->unmount() && ok;
+    }
+    
+    mutex_guard guard(_mutex);
+    _keys.clear();
+    return ok;
+}
+
+bool storage_tiering::format() {
+    mutex_guard guard(_mutex);
+    
+    bool ok = true;
+    for (auto* tier : _tiers) {
+        ok = tier->format() && ok;
+    }
+    
+    // Dropping every entry also aborts any migration in flight
+    _keys.clear();
+    return ok;
+}
+
+bool storage_tiering::get_is_mounted() const {
+    if (_tiers.empty()) {
+        return false;
+    }
+    for (auto* tier : _tiers) {
+        if (!tier->get_is_mounted()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool storage_tiering::read_file(const std::string& key, void* data, size_t data_size) {
+    int tier = _locate(key);
+    if (tier < 0) {
+        return false;
+    }
+    
+    {
+        mutex_guard guard(_mutex);
+        auto it = _keys.find(key);
+        if (it != _keys.end()) {
+            it->second.hits++;
+        }
+    }
+    
+    if (_tiers[tier]->read_file(key, data, data_size)) {
+        return true;
+    }
+    
+    // A migration may have switched the key and erased the copy we were reading
+    int current = _locate(key);
+    if (current >= 0 && current != tier) {
+        return _tiers[current]->read_file(key, data, data_size);
+    }
+    return false;
+}
+
+bool storage_tiering::write_file(const std::string& key, const void* data, size_t data_size) {
+    if (_tiers.empty()) {
+        return false;
+    }
+    
+    int existing = _locate(key);
+    
+    int tier;
+    {
+        mutex_guard guard(_mutex);
+        auto it = _keys.find(key);
+        if (it == _keys.end()) {
+            // New keys start cold; reads earn them a faster tier
+            it = _keys.emplace(key, key_state{existing >= 0 ? existing : (int)_tiers.size() - 1,
+                                              0, 0, 0, 0, false, false}).first;
+        }
+        // Erased mid-migration: the key comes back on the tier it was erased from,
+        // never on the destination the migration is about to discard
+        it->second.erased = false;
+        // Any migration that snapshotted the old generation will now abort
+        it->second.generation = _next_generation++;
+        it->second.writers++;
+        tier = it->second.tier;
+    }
+    
+    bool ok = _tiers[tier]->write_file(key, data, data_size);
+    
+    mutex_guard guard(_mutex);
+    auto it = _keys.find(key);
+    if (it != _keys.end()) {
+        it->second.writers--;
+        it->second.generation = _next_generation++;
+        it->second.size = data_size;
+        if (!ok && !it->second.in_flight) {
+            // State on the tier is unknown now - probe again on next access
+            _keys.erase(it);
+        }
+    }
+    return ok;
+}
+
+bool storage_tiering::erase_file(const std::string& key) {
+    int tier = _locate(key);
+    if (tier < 0) {
+        return false;
+    }
+    
+    {
+        mutex_guard guard(_mutex);
+        // Dropping the entry aborts any migration of this key. One in flight
+        // keeps it, marked erased, until the migration has discarded its copy
+        auto it = _keys.find(key);
+        if (it != _keys.end() && it->second.in_flight) {
+            it->second.erased = true;
+            it->second.generation = _next_generation++;
+        } else if (it != _keys.end()) {
+            _keys.erase(it);
+        }
+    }
+    
+    return _tiers[tier]->erase_file(key);
+}
+
+size_t storage_tiering::file_size(const std::string& key) {
+    int tier = _locate(key);
+    if (tier < 0) {
+        return 0;
+    }
+    
+    mutex_guard guard(_mutex);
+    auto it = _keys.find(key);
+    return it != _keys.end() ? it->second.size : 0;
+}
+
+bool storage_tiering::exists(const std::string& key) {
+    return _locate(key) >= 0;
+}
+
+size_t storage_tiering::total_size() {
+    size_t total = 0;
+    for (auto* tier : _tiers) {
+        total += tier->total_size();
+    }
+    return total;
+}
+
+size_t storage_tiering::used_size() {
+    size_t used = 0;
+    for (auto* tier : _tiers) {
+        used += tier->used_size();
+    }
+    return used;
+}
+
+bool storage_tiering::list_all_files(std::vector<file_info_t>& files) {
+    files.clear();
+    
+    // A key caught mid-migration exists on two tiers; report it once
+    std::unordered_set<std::string> seen;
+    std::vector<file_info_t> tier_files;
+    bool ok = true;
+    
+    for (auto* tier : _tiers) {
+        tier_files.clear();
+        if (!tier->list_all_files(tier_files)) {
+            ok = false;
+            continue;
+        }
+        for (const auto& info : tier_files) {
+            if (seen.insert(info.path).second) {
+                files.push_back(info);
+            }
+        }
+    }
+    return ok;
+}
+
+// ========== Migration ==========
+
+void storage_tiering::_plan(size_t max_moves, std::vector<migration>& moves) {
+    mutex_guard guard(_mutex);
+    
+    std::vector<const std::pair<const std::string, key_state>*> promote;
+    std::vector<const std::pair<const std::string, key_state>*> demote;
+    
+    for (const auto& entry : _keys) {
+        const key_state& state = entry.second;
+        if (state.writers > 0 || state.in_flight) {
+            continue;
+        }
+        if (state.tier > 0 && state.hits >= STORAGE_TIER_PROMOTE_HITS &&
+            state.size <= STORAGE_TIER_MAX_PROMOTE_SIZE) {
+            promote.push_back(&entry);
+        } else if (state.tier < (int)_tiers.size() - 1 &&
+                   (state.hits <= STORAGE_TIER_DEMOTE_HITS || state.size > STORAGE_TIER_MAX_PROMOTE_SIZE)) {
+            demote.push_back(&entry);
+        }
+    }
+    
+    // Hottest first up, coldest first down; demotions make room for promotions
+    std::sort(promote.begin(), promote.end(), [](const std::pair<const std::string, key_state>* a,
+                                                 const std::pair<const std::string, key_state>* b) {
+        return a->second.hits > b->second.hits;
+    });
+    std::sort(demote.begin(), demote.end(), [](const std::pair<const std::string, key_state>* a,
+                                               const std::pair<const std::string, key_state>* b) {
+        return a->second.hits < b->second.hits;
+    });
+    
+    for (size_t i = 0; i < demote.size() && moves.size() < max_moves; i++) {
+        const key_state& state = demote[i]->second;
+        moves.push_back({demote[i]->first, state.tier, state.tier + 1, state.generation});
+    }
+    for (size_t i = 0; i < promote.size() && moves.size() < max_moves; i++) {
+        const key_state& state = promote[i]->second;
+        moves.push_back({promote[i]->first, state.tier, state.tier - 1, state.generation});
+    }
+    
+    // Age the counters so a key has to stay busy to stay hot
+    for (auto& entry : _keys) {
+        entry.second.hits /= 2;
+    }
+}
+
+bool storage_tiering::_move(const migration& move) {
+    storage_interface* source = _tiers[move.from];
+    storage_interface* destination = _tiers[move.to];
+    
+    {
+        // Claim the key; passes from the task and from migrate_step() may overlap
+        mutex_guard guard(_mutex);
+        auto it = _keys.find(move.key);
+        if (it == _keys.end() || it->second.in_flight || it->second.generation != move.generation) {
+            _aborted++;
+            return false;
+        }
+        it->second.in_flight = true;
+    }
+    
+    size_t size = source->file_size(move.key);
+    std::vector<uint8_t> buffer(size);
+    
+    bool copied = source->read_file(move.key, buffer.data(), size) &&
+                  destination->write_file(move.key, buffer.data(), size);
+    
+    {
+        mutex_guard guard(_mutex);
+        auto it = _keys.find(move.key);
+        bool unchanged = it != _keys.end() && it->second.tier == move.from &&
+                         it->second.generation == move.generation && it->second.writers == 0;
+        
+        if (copied && unchanged) {
+            // Readers see the new tier from here on; one still reading the source
+            // retries on the destination if the erase below beats it
+            it->second.tier = move.to;
+            it->second.size = size;
+            it->second.in_flight = false;
+        } else {
+            copied = false;
+        }
+    }
+    
+    if (!copied) {
+        // Written, erased or failed mid-copy - the source stays authoritative.
+        // The lock is held across the erase so no write can choose the
+        // destination meanwhile, and a write that already landed there (the
+        // entries were cleared by format()) keeps its copy.
+        mutex_guard guard(_mutex);
+        auto it = _keys.find(move.key);
+        if (it == _keys.end() || it->second.erased || it->second.tier != move.to) {
+            destination->erase_file(move.key);
+        }
+        if (it != _keys.end() && it->second.in_flight) {
+            it->second.in_flight = false;
+            if (it->second.erased) {
+                _keys.erase(it);
+            }
+        }
+        _aborted++;
+        return false;
+    }
+    
+    source->erase_file(move.key);
+
+#if STORAGE_ENABLE_DEBUG_LOGGING
+    ESP_LOGD(TAG, "Moved %s from tier %d to tier %d (%zu bytes)",
+             move.key.c_str(), move.from, move.to, size);
+#endif
+    return true;
+}
+
+size_t storage_tiering::migrate_step(size_t max_moves) {
+    if (_tiers.size() < 2) {
+        return 0;
+    }
+    
+    std::vector<migration> moves;
+    _plan(max_moves, moves);
+    
+    // Copies run without the lock so foreground I/O is never held up by them
+    size_t moved = 0;
+    for (const auto& move : moves) {
+        if (_move(move)) {
+            moved++;
+            if (move.to < move.from) {
+                _promotions++;
+            } else {
+                _demotions++;
+            }
+        }
+    }
+    return moved;
+}
+
+bool storage_tiering::start_migration(uint32_t interval_ms) {
+    if (_task_running) {
+        return true;
+    }
+    if (_task_events == nullptr) {
+        return false;
+    }
+    
+    _interval_ms = interval_ms;
+    _task_stop = false;
+    xEventGroupClearBits(_task_events, TASK_EXITED_BIT);
+    _task_running = true;
+    
+    if (xTaskCreate(_migration_task, "storage_tier", STORAGE_TIER_TASK_STACK_SIZE, this,
+                    STORAGE_TIER_TASK_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create migration task");
+        _task_running = false;
+        return false;
+    }
+    return true;
+}
+
+void storage_tiering::stop_migration() {
+    if (!_task_running) {
+        return;
+    }
+    
+    _task_stop = true;
+    xEventGroupWaitBits(_task_events, TASK_EXITED_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
+    _task_running = false;
+}
+
+void storage_tiering::_migration_task(void* arg) {
+    storage_tiering* self = static_cast<storage_tiering*>(arg);
+    
+    while (!self->_task_stop) {
+        vTaskDelay(pdMS_TO_TICKS(self->_interval_ms));
+        if (!self->_task_stop) {
+            self->migrate_step();
+        }
+    }
+    
+    xEventGroupSetBits(self->_task_events, TASK_EXITED_BIT);
+    vTaskDelete(NULL);
+}
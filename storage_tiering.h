@@ -0,0 +1,131 @@
+#pragma once
+
+#include "interface/storage_interface.h"
+#include "storage_config.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+
+/**
+ * @brief storage_interface over tiers ordered fastest first, with hot/cold migration
+ *
+ * New keys land on the slowest tier. Reads count accesses per key; a migration
+ * pass promotes keys that became hot (and are small enough) one tier up and
+ * demotes keys that went cold one tier down, then halves every count so old
+ * accesses fade. Passes run on a background task or through migrate_step().
+ *
+ * A key is moved by copying it, switching its location, then erasing the
+ * source. The switch is skipped if the key was written or erased while being
+ * copied, and a read that races the switch retries on the new tier, so reads
+ * and writes stay correct during migration. A key being copied keeps its entry
+ * even when erased, so no lookup probes the tiers and mistakes the unfinished
+ * copy for the key. Key locations live in RAM and are rediscovered by probing
+ * the tiers after a reboot.
+ */
+class storage_tiering : public storage_interface
+{
+    public:
+        storage_tiering();
+        ~storage_tiering();
+
+        // ===== Configuration =====
+        /**
+         * @brief Append a tier slower than all tiers added so far; not owned
+         * @return Tier index, or -1 on failure
+         */
+        int add_tier(storage_interface* tier);
+
+        // ===== storage_interface implementation =====
+        bool begin() override;
+        bool read_file(const std::string& key, void* data, size_t data_size) override;
+        bool write_file(const std::string& key, const void* data, size_t data_size) override;
+        bool erase_file(const std::string& key) override;
+        size_t file_size(const std::string& key) override;
+        bool exists(const std::string& key) override;
+        size_t total_size() override;
+        size_t used_size() override;
+        bool mount(bool format_on_fail = STORAGE_FORMAT_IF_MOUNT_FAILS) override;
+        bool unmount() override;
+        bool format() override;
+        bool list_all_files(std::vector<file_info_t>& files) override;
+        bool get_is_mounted() const override;
+
+        // ===== Migration =====
+        /**
+         * @brief Start the background migration task
+         */
+        bool start_migration(uint32_t interval_ms = STORAGE_TIER_MIGRATE_INTERVAL_MS);
+        void stop_migration();
+
+        /**
+         * @brief Run one migration pass in the caller's context
+         * @return Number of keys moved
+         */
+        size_t migrate_step(size_t max_moves = STORAGE_TIER_MIGRATE_BATCH);
+
+        /**
+         * @brief Tier currently holding key, or -1 if it is not stored
+         */
+        int get_tier_of(const std::string& key);
+
+        // ===== Getters =====
+        size_t get_tier_count() const { return _tiers.size(); }
+        uint32_t get_promotions() const { return _promotions; }
+        uint32_t get_demotions() const { return _demotions; }
+        uint32_t get_aborted_migrations() const { return _aborted; }
+
+    private:
+        struct key_state {
+            int tier;
+            size_t size;
+            uint32_t hits;
+            uint32_t generation;  // Changes on every write and erase
+            uint32_t writers;     // Writes in flight
+            bool in_flight;       // A migration is copying the key
+            bool erased;          // Erased while in flight; dropped when the migration ends
+        };
+
+        struct migration {
+            std::string key;
+            int from;
+            int to;
+            uint32_t generation;
+        };
+
+        std::vector<storage_interface*> _tiers;
+        std::unordered_map<std::string, key_state> _keys;
+        uint32_t _next_generation;
+        uint32_t _promotions;
+        uint32_t _demotions;
+        uint32_t _aborted;
+
+        SemaphoreHandle_t _mutex;
+        EventGroupHandle_t _task_events;
+        std::atomic<bool> _task_running;
+        std::atomic<bool> _task_stop;
+        uint32_t _interval_ms;
+        static const EventBits_t TASK_EXITED_BIT = (1 << 0);
+        static void _migration_task(void* arg);
+
+        class mutex_guard {
+        public:
+            explicit mutex_guard(SemaphoreHandle_t& mutex) : m_mutex(mutex) {
+                xSemaphoreTake(m_mutex, STORAGE_MUTEX_TIMEOUT_MS);
+            }
+            ~mutex_guard() {
+                xSemaphoreGive(m_mutex);
+            }
+        private:
+            SemaphoreHandle_t& m_mutex;
+        };
+
+        // ===== Internal helpers =====
+        int _locate(const std::string& key);
+        bool _move(const migration& move);
+        void _plan(size_t max_moves, std::vector<migration>& moves);
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "storage_esp.h"
+#include "esp_log.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Tests for the storage driver's bookkeeping
+ * 
+ * Not part of the storage component: build test/ into an application (see
+ * the README). Each test checks the invariants of one feature against a
+ * partition it formats, or against ram_storage, and stops at the first
+ * check that fails.
+ */
+
+/**
+ * @brief Partition a test may format and use
+ */
+struct test_target {
+    storage_type_t type = STORAGE_DEFAULT_TYPE;
+    std::string partition = STORAGE_DEFAULT_PARTITION_LABEL;
+    std::string mount_point = STORAGE_DEFAULT_BASE_PATH;
+};
+
+/**
+ * @brief Fail the calling test, logging the condition, unless it holds
+ */
+#define TEST_CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            ESP_LOGE("storage_test", "%s:%d: %s", __FILE__, __LINE__, #condition); \
+            return false; \
+        } \
+    } while (0)
+
+/**
+ * @brief Mount storage on the target and start from an empty filesystem
+ */
+template <class Storage>
+bool test_prepare(Storage& storage) {
+    if (!storage.begin() || !storage.format()) {
+        ESP_LOGE("storage_test", "Could not mount and format the test partition");
+        return false;
+    }
+    return true;
+}
+
+// ===== Tests =====
+bool test_listing(const test_target& target);
+bool test_index(const test_target& target);
+bool test_tiering(const test_target& target);
+bool test_reserve(const test_target& target);
+bool test_quota(const test_target& target);
+bool test_evict(const test_target& target);
+bool test_ttl(const test_target& target);
+bool test_fsck(const test_target& target);
@@ -0,0 +1,80 @@
+#include "storage_test.h"
+
+static const size_t CHUNK = 4096;
+static const size_t VERSIONED_SIZE = 4 * CHUNK;
+
+/**
+ * @brief Writes evictable CHUNK files cache/c0, c1, ... until free space drops below floor
+ * @return Number of files written
+ */
+template <class Storage>
+static size_t fill_cache(Storage& storage, size_t floor) {
+    std::vector<uint8_t> data(CHUNK, 0xC5);
+    storage_write_options_t cache;
+    cache.evictable = true;
+    size_t files = 0;
+    while (storage.total_size() - storage.used_size() >= floor &&
+           storage.write_file("cache/c" + std::to_string(files), data.data(), data.size(), cache)) {
+        files++;
+    }
+    return files;
+}
+
+/**
+ * @brief Least recently used evictable files make room for writes that would not fit
+ * 
+ * Reads refresh recency, permanent files are never evicted, the set
+ * survives a clean remount and goes with remove_tree(""). With versioning,
+ * rewriting a file asks for room for its archive too.
+ */
+bool test_evict(const test_target& target) {
+    storage_esp_config config;
+    config.versioning = false;
+    {
+        storage_esp storage(target.type, target.partition, target.mount_point, config);
+        if (!test_prepare(storage)) {
+            return false;
+        }
+        
+        size_t files = fill_cache(storage, storage.total_size() * 2 / 5);
+        TEST_CHECK(files >= 2 && storage.get_evictable_count() == files);
+        char byte;
+        TEST_CHECK(storage.read_file("cache/c0", &byte, 1));
+        
+        // Grow a permanent file until the cache has to give way
+        std::vector<uint8_t> data(CHUNK, 0x5A);
+        size_t size = 0;
+        while (storage.get_evictions() == 0 && size < storage.total_size()) {
+            TEST_CHECK(storage.write_file_range("perm", size, data.data(), data.size()));
+            size += CHUNK;
+        }
+        TEST_CHECK(storage.get_evictions() > 0);
+        TEST_CHECK(storage.exists("cache/c0") && !storage.exists("cache/c1"));
+        TEST_CHECK(storage.exists("perm") && !storage.is_evictable("perm"));
+        TEST_CHECK(storage.is_evictable("cache/c0"));
+        
+        size_t count = storage.get_evictable_count();
+        TEST_CHECK(storage.unmount() && storage.mount());
+        TEST_CHECK(storage.get_evictable_count() == count && storage.is_evictable("cache/c0"));
+        
+        TEST_CHECK(storage.remove_tree(""));
+        TEST_CHECK(storage.get_evictable_count() == 0 && !storage.is_evictable("cache/c0"));
+        storage.format();
+    }
+    
+    // Rewriting a versioned file keeps the old contents as an archive
+    config.versioning = true;
+    storage_esp storage(target.type, target.partition, target.mount_point, config);
+    if (!test_prepare(storage)) {
+        return false;
+    }
+    std::vector<uint8_t> data(VERSIONED_SIZE, 0x11);
+    TEST_CHECK(storage.write_file("versioned", data.data(), data.size()));
+    TEST_CHECK(fill_cache(storage, VERSIONED_SIZE) > 0);
+    data[0] = 0x22;
+    TEST_CHECK(storage.write_file("versioned", data.data(), data.size()));
+    TEST_CHECK(storage.get_evictions() > 0);
+    
+    storage.format();
+    return true;
+}
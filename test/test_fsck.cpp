@@ -0,0 +1,88 @@
+#include "storage_test.h"
+#include <cstdio>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const size_t KEYS = 8;
+static const size_t MAX_STEPS = 500;
+
+/**
+ * @brief Contents of the checker's cursor file, or "-" if there is none
+ */
+static std::string read_cursor(const std::string& mount_point) {
+    FILE* f = fopen((mount_point + "/" STORAGE_FSCK_CURSOR_FILE).c_str(), "r");
+    if (!f) {
+        return "-";
+    }
+    std::string cursor;
+    char buffer[64];
+    size_t length;
+    while ((length = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        cursor.append(buffer, length);
+    }
+    fclose(f);
+    return cursor;
+}
+
+/**
+ * @brief The consistency checker finishes, and its cursor always names a file
+ * 
+ * Every data file is deleted behind the driver's back, so each step's
+ * repair removes artifacts the open walk may still return. The check
+ * starts from a cursor naming an artifact that does not exist and is
+ * interrupted by a remount; the saved cursor must never name a deleted
+ * artifact and the check must end within a bounded number of steps.
+ */
+bool test_fsck(const test_target& target) {
+    storage_esp_config config;
+    config.fsck_step_us = 0;
+    {
+        storage_esp storage(target.type, target.partition, target.mount_point, config);
+        if (!test_prepare(storage)) {
+            return false;
+        }
+        for (size_t i = 0; i < KEYS; i++) {
+            std::string key = "d/k" + std::to_string(i);
+            TEST_CHECK(storage.write_file(key, "aa", 2) && storage.write_file(key, "bb", 2));
+        }
+        TEST_CHECK(storage.unmount());
+    }
+    
+    // Without the checker, unmount leaves the cursor file that marks a crash
+    {
+        storage_esp_config plain = config;
+        plain.fsck = false;
+        storage_esp storage(target.type, target.partition, target.mount_point, plain);
+        TEST_CHECK(storage.begin());
+        for (size_t i = 0; i < KEYS; i++) {
+            TEST_CHECK(unlink((target.mount_point + "/d/k" + std::to_string(i)).c_str()) == 0);
+        }
+        FILE* f = fopen((target.mount_point + "/" STORAGE_FSCK_CURSOR_FILE).c_str(), "w");
+        TEST_CHECK(f);
+        fputs("d/gone.v1", f);
+        fclose(f);
+        TEST_CHECK(storage.unmount());
+    }
+    
+    storage_esp storage(target.type, target.partition, target.mount_point, config);
+    TEST_CHECK(storage.begin() && storage.is_check_pending());
+    size_t steps = 0;
+    while (!storage.check_step()) {
+        TEST_CHECK(++steps < MAX_STEPS);
+        std::string cursor = read_cursor(target.mount_point);
+        struct stat st;
+        TEST_CHECK(cursor.empty() || stat((target.mount_point + "/" + cursor).c_str(), &st) == 0);
+        if (steps == KEYS / 2) {
+            TEST_CHECK(storage.unmount() && storage.mount() && storage.is_check_pending());
+        }
+    }
+    
+    TEST_CHECK(!storage.is_check_pending() && storage.get_check_repairs() > 0);
+    for (size_t i = 0; i < KEYS; i++) {
+        TEST_CHECK(!storage.exists("d/k" + std::to_string(i) + STORAGE_VERSION_METADATA_EXT));
+    }
+    TEST_CHECK(storage.unmount() && storage.mount() && !storage.is_check_pending());
+    
+    storage.format();
+    return true;
+}
@@ -0,0 +1,90 @@
+#include "storage_test.h"
+#include "metadata_index.h"
+#include <cstdio>
+
+/**
+ * @brief Overwrites four bytes of a file at offset
+ */
+static bool patch_file(const std::string& path, long offset, uint32_t value) {
+    FILE* f = fopen(path.c_str(), "r+b");
+    if (!f) {
+        return false;
+    }
+    bool ok = fseek(f, offset, SEEK_SET) == 0 && fwrite(&value, sizeof(value), 1, f) == 1;
+    return (fclose(f) == 0) && ok;
+}
+
+/**
+ * @brief The metadata index snapshot and the keys reserved for it
+ * 
+ * A snapshot round-trips, one with a corrupt entry count or a truncated
+ * body is rejected before anything is allocated for it, and a save never
+ * leaves its temporary file behind. Keys under the reserved prefix are
+ * refused, and the driver's own files stay out of listings.
+ */
+bool test_index(const test_target& target) {
+    storage_esp_config config;
+    config.versioning = false;
+    storage_esp storage(target.type, target.partition, target.mount_point, config);
+    if (!test_prepare(storage)) {
+        return false;
+    }
+    
+    std::string path = target.mount_point + "/" STORAGE_RESERVED_PREFIX "test_index";
+    metadata_index saved;
+    saved.put("a", 3, false);
+    saved.put("dir", 0, true);
+    saved.put("dir/b", 7, false);
+    TEST_CHECK(saved.save(path));
+    TEST_CHECK(!storage.exists(STORAGE_RESERVED_PREFIX "test_index.tmp"));
+    
+    metadata_index loaded;
+    metadata_index::entry info;
+    TEST_CHECK(loaded.load(path) && loaded.is_valid());
+    TEST_CHECK(loaded.size() == 3);
+    TEST_CHECK(loaded.lookup("dir/b", info) && info.size == 7 && !info.is_directory);
+    TEST_CHECK(loaded.lookup("dir", info) && info.is_directory);
+    
+    // The entry count follows the magic and format words
+    TEST_CHECK(patch_file(path, 2 * sizeof(uint32_t), 0xFFFFFFF0));
+    TEST_CHECK(!loaded.load(path) && !loaded.is_valid() && loaded.size() == 0);
+    
+    // So does one whose body is cut short
+    TEST_CHECK(saved.save(path));
+    std::vector<uint8_t> snapshot(storage.file_size(STORAGE_RESERVED_PREFIX "test_index"));
+    FILE* f = fopen(path.c_str(), "rb");
+    TEST_CHECK(f);
+    TEST_CHECK(fread(snapshot.data(), 1, snapshot.size(), f) == snapshot.size());
+    fclose(f);
+    f = fopen(path.c_str(), "wb");
+    TEST_CHECK(f);
+    fwrite(snapshot.data(), 1, snapshot.size() - 1, f);
+    fclose(f);
+    TEST_CHECK(!loaded.load(path));
+    
+    // A save cut short leaves only its temporary file, which the next load drops
+    f = fopen((path + ".tmp").c_str(), "wb");
+    TEST_CHECK(f);
+    fclose(f);
+    TEST_CHECK(saved.save(path) && loaded.load(path) && loaded.size() == 3);
+    remove(path.c_str());
+    
+    // Reserved keys would vanish from listings, so they are refused
+    TEST_CHECK(!storage.write_file(STORAGE_RESERVED_PREFIX "x", "x", 1));
+    TEST_CHECK(!storage.write_file(STORAGE_RESERVED_PREFIX "dir/x", "x", 1));
+    TEST_CHECK(!storage.create_directory(STORAGE_RESERVED_PREFIX "dir"));
+    TEST_CHECK(storage.write_file("k", "x", 1));
+    TEST_CHECK(!storage.rename_file("k", STORAGE_RESERVED_PREFIX "k"));
+    TEST_CHECK(storage.write_file("dir/" STORAGE_RESERVED_PREFIX "x", "x", 1));
+    
+    // A clean unmount writes the snapshot; the warm mount must agree with the files
+    TEST_CHECK(storage.unmount() && storage.mount());
+    TEST_CHECK(storage.exists("k") && storage.file_size("dir/" STORAGE_RESERVED_PREFIX "x") == 1);
+    TEST_CHECK(!storage.exists("a"));
+    std::vector<file_info_t> files;
+    TEST_CHECK(storage.list_all_files(files));
+    TEST_CHECK(files.size() == 2);
+    
+    storage.format();
+    return true;
+}
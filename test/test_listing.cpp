@@ -0,0 +1,56 @@
+#include "storage_test.h"
+
+/**
+ * @brief list_directory_page() pages through a directory in name order
+ * 
+ * The cursor must neither repeat nor skip a name that exists throughout,
+ * even when entries are added and removed between pages, and a missing
+ * directory is an error rather than an empty listing.
+ */
+bool test_listing(const test_target& target) {
+    storage_esp_config config;
+    config.versioning = false;
+    storage_esp storage(target.type, target.partition, target.mount_point, config);
+    if (!test_prepare(storage)) {
+        return false;
+    }
+    
+    const size_t FILES = 10;
+    for (size_t i = 0; i < FILES; i++) {
+        TEST_CHECK(storage.write_file("list/f" + std::to_string(i), "data", 1 + i % 4));
+    }
+    TEST_CHECK(storage.create_directory("list/sub"));
+    
+    dir_cursor_t cursor;
+    std::vector<file_info_t> page;
+    std::vector<std::string> seen;
+    while (!cursor.at_end()) {
+        page.clear();
+        TEST_CHECK(storage.list_directory_page("list", cursor, 3, page, STORAGE_ATTR_ALL));
+        TEST_CHECK(page.size() <= 3);
+        for (const auto& info : page) {
+            TEST_CHECK(seen.empty() || seen.back() < info.path);
+            TEST_CHECK(info.is_directory == (info.path == "list/sub"));
+            seen.push_back(info.path);
+        }
+        
+        // Churn behind and ahead of the cursor
+        if (seen.size() == 3) {
+            TEST_CHECK(storage.erase_file("list/f0"));
+            TEST_CHECK(storage.erase_file("list/f9"));
+            TEST_CHECK(storage.write_file("list/g", "new", 3));
+        }
+    }
+    // f0 was listed before it went, f9 went before it was reached
+    TEST_CHECK(seen.size() == FILES + 1);
+    TEST_CHECK(std::count(seen.begin(), seen.end(), "list/g") == 1);
+    TEST_CHECK(std::count(seen.begin(), seen.end(), "list/f9") == 0);
+    
+    page.clear();
+    cursor.reset();
+    TEST_CHECK(!storage.list_directory_page("missing", cursor, 3, page));
+    TEST_CHECK(page.empty());
+    
+    storage.format();
+    return true;
+}
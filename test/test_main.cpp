@@ -0,0 +1,33 @@
+#include "storage_test.h"
+
+static const char* TAG = "storage_test";
+
+static const struct {
+    const char* name;
+    bool (*run)(const test_target& target);
+} TESTS[] = {
+    {"listing", test_listing},
+    {"index", test_index},
+    {"tiering", test_tiering},
+    {"reserve", test_reserve},
+    {"quota", test_quota},
+    {"evict", test_evict},
+    {"ttl", test_ttl},
+    {"fsck", test_fsck},
+};
+
+/**
+ * @brief Runs every test against the default partition, which it formats
+ */
+extern "C" void app_main(void) {
+    test_target target;
+    unsigned failed = 0;
+    
+    for (const auto& test : TESTS) {
+        bool passed = test.run(target);
+        ESP_LOGI(TAG, "%s: %s", test.name, passed ? "passed" : "FAILED");
+        failed += passed ? 0 : 1;
+    }
+    
+    ESP_LOGI(TAG, "%u of %u tests failed", failed, (unsigned)(sizeof(TESTS) / sizeof(TESTS[0])));
+}
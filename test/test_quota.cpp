@@ -0,0 +1,70 @@
+#include "storage_test.h"
+
+/**
+ * @brief Current usage of a quota, or UINT64_MAX if none is set
+ */
+template <class Storage>
+static uint64_t quota_used(Storage& storage, const std::string& prefix) {
+    uint64_t used = 0;
+    size_t limit = 0;
+    return storage.get_quota(prefix, used, limit) ? used : UINT64_MAX;
+}
+
+/**
+ * @brief Quota usage stays equal to the bytes stored under the prefix
+ * 
+ * Every write, overwrite, truncation, erase, rename and tree removal keeps
+ * the count exact, so the limit is enforced without walking the directory.
+ * A key renamed onto itself, under any spelling, changes nothing.
+ */
+bool test_quota(const test_target& target) {
+    storage_esp_config config;
+    config.versioning = false;
+    storage_esp storage(target.type, target.partition, target.mount_point, config);
+    if (!test_prepare(storage)) {
+        return false;
+    }
+    
+    std::vector<uint8_t> data(4000, 0x5A);
+    TEST_CHECK(storage.write_file("q/old", data.data(), 500));
+    // Usage is counted when the quota is set
+    TEST_CHECK(storage.set_quota("q/", 5000));
+    TEST_CHECK(quota_used(storage, "q/") == 500);
+    
+    TEST_CHECK(storage.write_file("q/a", data.data(), 3000));
+    TEST_CHECK(!storage.write_file("q/b", data.data(), 2000));
+    TEST_CHECK(!storage.exists("q/b"));
+    TEST_CHECK(storage.write_file("q/b", data.data(), 1500));
+    TEST_CHECK(quota_used(storage, "q/") == 5000);
+    TEST_CHECK(!storage.write_file_range("q/b", 1500, data.data(), 1));
+    
+    // Overwrites and truncation count the difference
+    TEST_CHECK(storage.write_file("q/a", data.data(), 1000));
+    TEST_CHECK(quota_used(storage, "q/") == 3000);
+    TEST_CHECK(storage.truncate_file("q/b", 100));
+    TEST_CHECK(quota_used(storage, "q/") == 1600);
+    
+    TEST_CHECK(storage.rename_file("q/a", "q/a"));
+    TEST_CHECK(storage.rename_file("q/a", "/q/a/"));
+    TEST_CHECK(quota_used(storage, "q/") == 1600);
+    TEST_CHECK(!storage.rename_file("q/none", "q/none"));
+    
+    // Renames move usage across prefixes
+    TEST_CHECK(storage.rename_file("q/a", "out/a"));
+    TEST_CHECK(quota_used(storage, "q/") == 600);
+    TEST_CHECK(storage.rename_file("out/a", "q/sub/a"));
+    TEST_CHECK(quota_used(storage, "q/") == 1600);
+    
+    TEST_CHECK(storage.erase_file("q/old"));
+    TEST_CHECK(quota_used(storage, "q/") == 1100);
+    TEST_CHECK(storage.remove_tree("q/sub"));
+    TEST_CHECK(quota_used(storage, "q/") == 100);
+    TEST_CHECK(storage.remove_tree("q"));
+    TEST_CHECK(quota_used(storage, "q/") == 0);
+    
+    TEST_CHECK(storage.remove_quota("q/"));
+    TEST_CHECK(quota_used(storage, "q/") == UINT64_MAX);
+    
+    storage.format();
+    return true;
+}
@@ -0,0 +1,54 @@
+#include "storage_test.h"
+
+static const size_t CHUNK = 4096;
+
+/**
+ * @brief Space reservations follow their file and hold space against other writes
+ * 
+ * Only the unwritten part of a reservation counts. It survives renames of
+ * the file, of the file onto itself and of a parent directory, and other
+ * files cannot grow into it.
+ */
+bool test_reserve(const test_target& target) {
+    storage_esp_config config;
+    config.versioning = false;
+    storage_esp storage(target.type, target.partition, target.mount_point, config);
+    if (!test_prepare(storage)) {
+        return false;
+    }
+    
+    std::vector<uint8_t> chunk(CHUNK, 0x5A);
+    TEST_CHECK(storage.write_file("logs/cur", chunk.data(), 1000));
+    TEST_CHECK(storage.reserve("logs/cur", 20000));
+    TEST_CHECK(storage.get_reserved_bytes() == 19000);
+    
+    TEST_CHECK(storage.rename_file("logs/cur", "logs/cur"));
+    TEST_CHECK(storage.get_reserved_bytes() == 19000);
+    TEST_CHECK(storage.rename_file("logs", "old"));
+    TEST_CHECK(storage.get_reserved_bytes() == 19000);
+    // Writing under the new name draws on the same reservation
+    TEST_CHECK(storage.write_file_range("old/cur", 1000, chunk.data(), 1000));
+    TEST_CHECK(storage.get_reserved_bytes() == 18000);
+    TEST_CHECK(storage.release("old/cur", 10));
+    TEST_CHECK(storage.get_reserved_bytes() == 0 && storage.file_size("old/cur") == 10);
+    
+    // Another file may grow until it would eat into the reserved half
+    size_t free_before = storage.total_size() - storage.used_size();
+    size_t reserved = free_before / 2;
+    TEST_CHECK(storage.reserve("rec", reserved));
+    size_t filled = 0;
+    while (filled < free_before && storage.write_file_range("fill", filled, chunk.data(), CHUNK)) {
+        filled += CHUNK;
+    }
+    TEST_CHECK(filled + reserved <= free_before);
+    TEST_CHECK(storage.erase_file("fill"));
+    
+    // Nothing of the file is left, so all of the reservation is outstanding again
+    TEST_CHECK(storage.write_file_range("rec", 0, chunk.data(), CHUNK));
+    TEST_CHECK(storage.remove_tree(""));
+    TEST_CHECK(storage.get_reserved_bytes() == reserved);
+    TEST_CHECK(storage.release("rec"));
+    
+    storage.format();
+    return true;
+}
@@ -0,0 +1,80 @@
+#include "storage_test.h"
+#include "storage_tiering.h"
+#include "ram_storage.h"
+#include <functional>
+
+/**
+ * @brief ram_storage that runs a hook once, right after its next write
+ * 
+ * On the fast tier that is the moment a promotion has copied a key but not
+ * yet switched its location.
+ */
+class hooked_ram_storage : public ram_storage {
+    public:
+        std::function<void()> after_write;
+
+        bool write_file(const std::string& key, const void* data, size_t data_size) override {
+            bool ok = ram_storage::write_file(key, data, data_size);
+            if (after_write) {
+                std::function<void()> hook = std::move(after_write);
+                after_write = nullptr;
+                hook();
+            }
+            return ok;
+        }
+};
+
+/**
+ * @brief Reads a key often enough to make it hot
+ */
+static void heat(storage_tiering& tiering, const std::string& key) {
+    char buffer[8];
+    for (uint32_t i = 0; i <= STORAGE_TIER_PROMOTE_HITS; i++) {
+        tiering.read_file(key, buffer, 3);
+    }
+}
+
+/**
+ * @brief A promotion that loses a race with erase_file() or write_file()
+ * 
+ * Runs against two ram_storage tiers, so it needs no partition. The aborted
+ * move must neither drop the newer write nor leave its copy behind.
+ */
+bool test_tiering(const test_target&) {
+    hooked_ram_storage fast;
+    ram_storage slow;
+    storage_tiering tiering;
+    TEST_CHECK(tiering.add_tier(&fast) == 0 && tiering.add_tier(&slow) == 1);
+    TEST_CHECK(tiering.begin());
+    
+    char buffer[4] = {0};
+    TEST_CHECK(tiering.write_file("k", "old", 3));
+    TEST_CHECK(tiering.get_tier_of("k") == 1);
+    
+    // Erased and rewritten while being copied: the rewrite wins
+    heat(tiering, "k");
+    bool hook_ok = false;
+    fast.after_write = [&]() {
+        hook_ok = tiering.erase_file("k") && !tiering.exists("k") && tiering.write_file("k", "new", 3);
+    };
+    TEST_CHECK(tiering.migrate_step() == 0);
+    TEST_CHECK(hook_ok);
+    TEST_CHECK(tiering.get_aborted_migrations() == 1);
+    TEST_CHECK(tiering.read_file("k", buffer, 3) && memcmp(buffer, "new", 3) == 0);
+    TEST_CHECK(tiering.get_tier_of("k") == 1 && !fast.exists("k"));
+    
+    // Erased while being copied: nothing is left on either tier
+    heat(tiering, "k");
+    fast.after_write = [&]() { hook_ok = tiering.erase_file("k"); };
+    tiering.migrate_step();
+    TEST_CHECK(hook_ok);
+    TEST_CHECK(!tiering.exists("k") && !fast.exists("k") && !slow.exists("k"));
+    
+    // An undisturbed promotion still happens afterwards
+    TEST_CHECK(tiering.write_file("k", "abc", 3));
+    heat(tiering, "k");
+    TEST_CHECK(tiering.migrate_step() == 1);
+    TEST_CHECK(tiering.get_tier_of("k") == 0 && !slow.exists("k"));
+    TEST_CHECK(tiering.read_file("k", buffer, 3) && memcmp(buffer, "abc", 3) == 0);
+    return true;
+}
@@ -0,0 +1,65 @@
+#include "storage_test.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <sys/time.h>
+#include <ctime>
+
+/**
+ * @brief Expiry times are kept exactly, persisted, and never outlive their keys
+ * 
+ * An expired file reads as missing at once and is reaped later; renames
+ * carry the expiry, rewrites without a TTL drop it, and remove_tree("")
+ * leaves nothing behind in RAM or in the journal. Writes with a TTL fail
+ * while the clock is unset; if it is, the test then sets it.
+ */
+bool test_ttl(const test_target& target) {
+    storage_esp_config config;
+    config.versioning = false;
+    storage_esp storage(target.type, target.partition, target.mount_point, config);
+    if (!test_prepare(storage)) {
+        return false;
+    }
+    
+    storage_write_options_t ttl;
+    ttl.ttl_seconds = 1;
+    if (time(nullptr) < STORAGE_TTL_MIN_CLOCK) {
+        TEST_CHECK(!storage.write_file("early", "x", 1, ttl) && !storage.exists("early"));
+        struct timeval now = {STORAGE_TTL_MIN_CLOCK + 86400, 0};
+        TEST_CHECK(settimeofday(&now, NULL) == 0);
+    }
+    
+    TEST_CHECK(storage.write_file("sess/a", "x", 1, ttl));
+    ttl.ttl_seconds = 1000;
+    time_t written = time(nullptr);
+    TEST_CHECK(storage.write_file("sess/b", "x", 1, ttl));
+    TEST_CHECK(storage.write_file("sess/c", "x", 1, ttl));
+    TEST_CHECK(storage.write_file("sess/c", "x", 1));
+    TEST_CHECK(storage.get_expiry("sess/c") == 0);
+    time_t expiry = storage.get_expiry("sess/b");
+    TEST_CHECK(expiry >= written + 1000 && expiry <= time(nullptr) + 1000);
+    
+    TEST_CHECK(storage.rename_file("sess/b", "sess/b2"));
+    TEST_CHECK(storage.rename_file("sess", "old"));
+    TEST_CHECK(storage.get_expiry("old/b2") == expiry && storage.get_expiry("sess/b") == 0);
+    
+    vTaskDelay(pdMS_TO_TICKS(2100));
+    char byte;
+    TEST_CHECK(!storage.exists("old/a") && !storage.read_file("old/a", &byte, 1));
+    TEST_CHECK(storage.file_size("old/a") == 0);
+    
+    // The journal carries expiry times over a remount
+    TEST_CHECK(storage.unmount() && storage.mount());
+    TEST_CHECK(storage.get_expiry("old/b2") == expiry && !storage.exists("old/a"));
+    TEST_CHECK(storage.reap_expired() == 1);
+    TEST_CHECK(storage.exists("old/b2") && storage.exists("old/c"));
+    
+    // After remove_tree("") a key written again must not pick up its old expiry
+    TEST_CHECK(storage.remove_tree(""));
+    TEST_CHECK(storage.get_expiry("old/b2") == 0);
+    TEST_CHECK(storage.write_file("old/b2", "x", 1));
+    TEST_CHECK(storage.unmount() && storage.mount());
+    TEST_CHECK(storage.get_expiry("old/b2") == 0 && storage.exists("old/b2"));
+    
+    storage.format();
+    return true;
+}